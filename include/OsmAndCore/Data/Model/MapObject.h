@@ -31,6 +31,7 @@
 #include <QVector>
 #include <QString>
 #include <QHash>
+#include <QPair>
 
 #include <OsmAndCore.h>
 #include <OsmAndCore/CommonTypes.h>
@@ -40,44 +41,105 @@ namespace OsmAnd {
 
     class ObfMapSectionInfo;
     class ObfMapSectionReader_P;
+    class ObfStringTable;
     class Rasterizer_P;
 
     namespace Model {
 
         class OSMAND_CORE_API MapObject
         {
+        public:
+            //! Tag-value pairs, that map objects refer to by rule id. Single table is shared by all map objects of a section
+            class OSMAND_CORE_API EncodingDecodingRules
+            {
+                Q_DISABLE_COPY(EncodingDecodingRules)
+            private:
+            protected:
+            public:
+                //! Classes of rules, that are checked for each map object. Computed once, when rule is added
+                enum RuleFlag : uint32_t
+                {
+                    IsDefined = 1u << 0,
+                    IsCoastline = 1u << 1,
+                    IsOneway = 1u << 2,
+                    IsOnewayReverse = 1u << 3,
+                    IsName = 1u << 4,
+                    IsNegativeLayer = 1u << 5,
+                    IsZeroLayer = 1u << 6,
+                    IsPositiveLayer = 1u << 7,
+                    IsTunnel = 1u << 8,
+                    IsBridge = 1u << 9,
+                    HasYesValue = 1u << 10,
+                };
+
+                struct DecodingRule
+                {
+                    DecodingRule();
+
+                    TagValue tagValue;
+                    uint32_t flags;
+                };
+
+                EncodingDecodingRules();
+                virtual ~EncodingDecodingRules();
+
+                QHash< QString, QHash<QString, uint32_t> > encodingRules;
+                //! Dense table indexed by rule id. Ids that were never added have no flags, not even IsDefined
+                QVector< DecodingRule > decodingRules;
+                unsigned int decodingRulesCount;
+
+                void addRule(uint32_t ruleId, const QString& tag, const QString& value);
+                bool lookupRuleId(const QString& tag, const QString& value, uint32_t& outRuleId) const;
+                const TagValue& decodeRule(uint32_t ruleId) const;
+                uint32_t getRuleFlags(uint32_t ruleId) const;
+            };
         private:
         protected:
-            MapObject(const std::shared_ptr<const ObfMapSectionInfo>& section);
+            MapObject(const std::shared_ptr<const ObfMapSectionInfo>& section, const std::shared_ptr<const EncodingDecodingRules>& rules);
 
             uint64_t _id;
             MapFoundationType _foundation;
             bool _isArea;
             QVector< PointI > _points31;
             QList< QVector< PointI > > _innerPolygonsPoints31;
-            QVector< TagValue > _types;
-            QVector< TagValue > _extraTypes;
-            QHash< QString, QString > _names;
+            QVector< uint32_t > _typesRuleIds;
+            QVector< uint32_t > _extraTypesRuleIds;
+            QVector< QPair<uint32_t, uint32_t> > _namesIds;
+            std::shared_ptr<const ObfStringTable> _stringTable;
             AreaI _bbox31;
         public:
             virtual ~MapObject();
 
             const std::shared_ptr<const ObfMapSectionInfo> section;
+            const std::shared_ptr<const EncodingDecodingRules> rules;
 
             const uint64_t& id;
             const bool& isArea;
             const QVector< PointI >& points31;
             const QList< QVector< PointI > >& innerPolygonsPoints31;
-            const QVector< TagValue >& types;
-            const QVector< TagValue >& extraTypes;
+            const QVector< uint32_t >& typesRuleIds;
+            const QVector< uint32_t >& extraTypesRuleIds;
             const MapFoundationType& foundation;
-            const QHash<QString, QString>& names;
             const AreaI& bbox31;
 
+            const TagValue& getType(int typeIndex) const;
+            const TagValue& getExtraType(int typeIndex) const;
+
+            //! Names are kept as string indices of data block, and are decoded only on request.
+            //! Empty names are dropped while reading, so hasNames() means "has a non-empty name"
+            bool hasNames() const;
+            QHash<QString, QString> getNames() const;
+            int getNamesCount() const;
+            const QString& getNameTag(int nameIndex) const;
+            QString getName(int nameIndex) const;
+            QString getNameByTag(const QString& tag) const;
+
             int getSimpleLayerValue() const;
             bool isClosedFigure(bool checkInner = false) const;
 
             bool containsType(const QString& tag, const QString& value, bool checkAdditional = false) const;
+            //! Checks if any type has given rule flag, without looking up strings
+            bool containsTypeWithFlag(const uint32_t ruleFlag, bool checkAdditional = false) const;
 
             size_t calculateApproxConsumedMemory() const;
 
@@ -39,6 +39,7 @@ namespace OsmAnd {
     class RoutePlanner;
     class ObfRoutingSectionReader_P;
     class ObfRoutingSubsectionInfo;
+    class ObfStringTable;
 
     namespace Model {
 
@@ -71,7 +72,8 @@ namespace OsmAnd {
             const std::shared_ptr<const Road> _ref;
 
             uint64_t _id;
-            QMap<uint32_t, QString> _names;
+            QMap<uint32_t, uint32_t> _namesIds;
+            std::shared_ptr<const ObfStringTable> _stringTable;
             QVector< PointI > _points;
             QVector< uint32_t > _types;
             QMap< uint32_t, QVector<uint32_t> > _pointsTypes;
@@ -84,7 +86,6 @@ namespace OsmAnd {
 
             const std::shared_ptr<const ObfRoutingSubsectionInfo> subsection;
             const uint64_t& id;
-            const QMap<uint32_t, QString>& names;
             const QVector< PointI >& points;
             const QVector< uint32_t >& types;
             const QMap< uint32_t, QVector<uint32_t> >& pointsTypes;
@@ -93,12 +94,20 @@ namespace OsmAnd {
             double getDirectionDelta(uint32_t originIdx, bool forward) const;
             double getDirectionDelta(uint32_t originIdx, bool forward, float distance) const;
 
+            //! Names are kept as string indices of data block, and are decoded only on request.
+            //! Empty names are dropped while reading, so hasNames() means "has a non-empty name"
+            bool hasNames() const;
+            QMap<uint32_t, QString> getNames() const;
+            QString getNameByTag(uint32_t tagRuleId) const;
+
             bool isLoop() const;
             RoadDirection getDirection() const;
             bool isRoundabout() const;
             QString getHighway() const;
             int getLanes() const;
 
+            size_t calculateApproxConsumedMemory() const;
+
         friend class OsmAnd::ObfRoutingSectionReader_P;
         friend class OsmAnd::RoutePlanner;
         };
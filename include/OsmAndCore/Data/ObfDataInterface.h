@@ -27,6 +27,7 @@
 #include <array>
 
 #include <QList>
+#include <QVector>
 
 #include <OsmAndCore.h>
 #include <OsmAndCore/CommonTypes.h>
@@ -38,8 +39,11 @@ namespace OsmAnd {
     class ObfsCollection;
     class ObfReader;
     class ObfFile;
+    class ObfSectionsSpatialIndex;
+    class ObfRoutingSubsectionInfo;
     namespace Model {
         class MapObject;
+        class Amenity;
     } // namespace Model
     class IQueryController;
 
@@ -49,14 +53,28 @@ namespace OsmAnd {
     private:
         const std::unique_ptr<ObfDataInterface_P> _d;
     protected:
-        ObfDataInterface(const QList< std::shared_ptr<ObfReader> >& readers);
+        ObfDataInterface(const QList< std::shared_ptr<ObfReader> >& readers,
+            const std::shared_ptr<const ObfSectionsSpatialIndex>& spatialIndex = nullptr);
     public:
         virtual ~ObfDataInterface();
 
         void obtainObfFiles(QList< std::shared_ptr<const ObfFile> >* outFiles = nullptr, IQueryController* controller = nullptr);
         void obtainBasemapPresenceFlag(bool& basemapPresent, IQueryController* controller = nullptr);
+        //! If enabled, map sections are read simultaneously on local storage thread pool. Disabled by default
+        void setParallelMapObjectsLoading(const bool enabled);
+        bool isParallelMapObjectsLoadingEnabled() const;
+
         void obtainMapObjects(QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut, MapFoundationType* foundationOut, const AreaI& area31, const ZoomLevel& zoom, IQueryController* controller = nullptr);
-        
+        //! Obtains map objects of many tiles of same zoom at once, reading each data block only once. Neighbouring
+        //! tiles share same instances of map objects. Results and foundations are listed in order of tiles
+        void obtainMapObjectsForTiles(QVector< QList< std::shared_ptr<const OsmAnd::Model::MapObject> > >* resultsOut, QVector<MapFoundationType>* foundationsOut,
+            const QList<TileId>& tileIds, const ZoomLevel& zoom, IQueryController* controller = nullptr);
+
+        //! Obtains routing subsections that contain data and intersect given area, along with readers they belong to
+        void obtainRoutingSubsections(QList< std::pair< std::shared_ptr<ObfReader>, std::shared_ptr<const ObfRoutingSubsectionInfo> > >* resultOut,
+            const AreaI& area31, const bool basemap, IQueryController* controller = nullptr);
+        void obtainAmenities(QList< std::shared_ptr<const OsmAnd::Model::Amenity> >* resultOut, const AreaI& area31, const ZoomLevel& zoom, IQueryController* controller = nullptr);
+
     friend class OsmAnd::ObfsCollection;
     };
 
@@ -63,6 +63,7 @@ namespace OsmAnd {
         const AreaI& area31;
 
     friend class OsmAnd::ObfMapSectionReader_P;
+    friend class OsmAnd::ObfReader_P;
     };
 
     class ObfMapSectionInfo_P;
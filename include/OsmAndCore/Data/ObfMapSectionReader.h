@@ -28,6 +28,7 @@
 #include <functional>
 
 #include <QList>
+#include <QVector>
 
 #include <OsmAndCore.h>
 #include <OsmAndCore/CommonTypes.h>
@@ -49,11 +50,78 @@ namespace OsmAnd {
         ~ObfMapSectionReader();
     protected:
     public:
+        struct DataBlocksCacheMetrics
+        {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t evictions;
+            unsigned int blocksCount;
+            size_t consumedMemory;
+            size_t memoryLimit;
+        };
+
+        //! Lightweight view of map object, that points into decoding buffers reused by entire scan.
+        //! View is valid only during visitor call, and has to be promoted to be kept any longer
+        struct MapObjectView
+        {
+            uint64_t id;
+            bool isArea;
+            MapFoundationType foundation;
+            AreaI bbox31;
+
+            const PointI* points31;
+            unsigned int points31Count;
+
+            //! Points of all inner polygons, one after another, split by innerPolygonsSizes
+            const PointI* innerPolygonsPoints31;
+            const unsigned int* innerPolygonsSizes;
+            unsigned int innerPolygonsCount;
+
+            //! Rule ids, that can be resolved using decodeRule()
+            const uint32_t* typesRuleIds;
+            unsigned int typesCount;
+            const uint32_t* extraTypesRuleIds;
+            unsigned int extraTypesCount;
+
+            //! Pairs of (tag rule id, index in string table of data block)
+            const uint32_t* namesIds;
+            unsigned int namesCount;
+        };
+
         static void loadMapObjects(const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
             ZoomLevel zoom, const AreaI* bbox31 = nullptr,
             QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut = nullptr, MapFoundationType* foundationOut = nullptr,
             std::function<bool (const std::shared_ptr<const OsmAnd::Model::MapObject>&)> visitor = nullptr,
             IQueryController* controller = nullptr);
+
+        //! Loads map objects for many areas at once. Each data block is read and decoded once, and each map object
+        //! is given to every area it intersects as same instance. Results and foundations are listed in order of areas
+        static void loadMapObjectsForAreas(const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+            ZoomLevel zoom, const QVector<AreaI>& areas31,
+            QVector< QList< std::shared_ptr<const OsmAnd::Model::MapObject> > >* resultsOut = nullptr, QVector<MapFoundationType>* foundationsOut = nullptr,
+            IQueryController* controller = nullptr);
+
+        //! Visits map objects without creating them. If visitor returns true, view is promoted to
+        //! complete MapObject and put to promotedOut. No visitor means promote everything
+        static void scanMapObjects(const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+            ZoomLevel zoom, const AreaI* bbox31,
+            std::function<bool (const MapObjectView&)> visitor,
+            QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* promotedOut = nullptr, MapFoundationType* foundationOut = nullptr,
+            IQueryController* controller = nullptr);
+        //! Resolves rule id of MapObjectView. Rules of section are available once it was scanned or loaded
+        static bool decodeRule(const std::shared_ptr<const ObfMapSectionInfo>& section, uint32_t ruleId, TagValue& outTagValue);
+
+        //! Geometry may be simplified while decoding, dropping vertices closer than given distance (in pixels
+        //! of 256-pixel tiles at query zoom) to previous kept vertex. First and last vertices are always kept, and
+        //! rings are never reduced to less than a triangle. Zero tolerance (default) disables simplification
+        static void setGeometrySimplificationTolerance(const float tolerance);
+        static float getGeometrySimplificationTolerance();
+
+        //! Decoded map data blocks are shared by all queries. Zero limit disables caching
+        static void setDataBlocksCacheMemoryLimit(const size_t limitInBytes);
+        static size_t getDataBlocksCacheMemoryLimit();
+        static DataBlocksCacheMetrics getDataBlocksCacheMetrics();
+        static void clearDataBlocksCache();
     };
 
 } // namespace OsmAnd
@@ -44,6 +44,7 @@ namespace OsmAnd {
         class Road;
     } // namespace Model
     class IQueryFilter;
+    class IQueryController;
 
     class OSMAND_CORE_API ObfRoutingSectionReader
     {
@@ -52,6 +53,16 @@ namespace OsmAnd {
         ~ObfRoutingSectionReader();
     protected:
     public:
+        struct SubsectionsDataCacheMetrics
+        {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t evictions;
+            unsigned int subsectionsCount;
+            size_t consumedMemory;
+            size_t memoryLimit;
+        };
+
         static void querySubsections(const std::shared_ptr<ObfReader>& reader, const QList< std::shared_ptr<ObfRoutingSubsectionInfo> >& in,
             QList< std::shared_ptr<const ObfRoutingSubsectionInfo> >* resultOut = nullptr,
             IQueryFilter* filter = nullptr,
@@ -61,13 +72,20 @@ namespace OsmAnd {
             QList< std::shared_ptr<const Model::Road> >* resultOut = nullptr,
             QMap< uint64_t, std::shared_ptr<const Model::Road> >* resultMapOut = nullptr,
             IQueryFilter* filter = nullptr,
-            std::function<bool (const std::shared_ptr<const OsmAnd::Model::Road>&)> visitor = nullptr);
+            std::function<bool (const std::shared_ptr<const OsmAnd::Model::Road>&)> visitor = nullptr,
+            IQueryController* controller = nullptr);
 
         static void loadSubsectionBorderBoxLinesPoints(const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const ObfRoutingSectionInfo>& section,
             QList< std::shared_ptr<const ObfRoutingBorderLinePoint> >* resultOut = nullptr,
             IQueryFilter* filter = nullptr,
             std::function<bool (const std::shared_ptr<const ObfRoutingBorderLineHeader>&)> visitorLine = nullptr,
             std::function<bool (const std::shared_ptr<const ObfRoutingBorderLinePoint>&)> visitorPoint = nullptr);
+
+        //! Decoded routing subsections are shared by all routing contexts. Zero limit disables caching
+        static void setSubsectionsDataCacheMemoryLimit(const size_t limitInBytes);
+        static size_t getSubsectionsDataCacheMemoryLimit();
+        static SubsectionsDataCacheMetrics getSubsectionsDataCacheMetrics();
+        static void clearSubsectionsDataCache();
     };
 
 } // namespace OsmAnd
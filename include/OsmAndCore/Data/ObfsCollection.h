@@ -51,6 +51,24 @@ namespace OsmAnd {
         void registerExplicitFile(const QFileInfo& fileInfo);
         void registerExplicitFile(const QString& filePath);
 
+        // Maximal number of idle readers kept opened for each file
+        void setMaxReadersPerFile(unsigned int maxReadersPerFile);
+        unsigned int getMaxReadersPerFile() const;
+
+        // File where information about all files of collection is stored between runs, to avoid
+        // parsing each file on start. Empty path (default) disables index
+        void setIndexFilePath(const QString& indexFilePath);
+        QString getIndexFilePath() const;
+
+        // Watches directories and explicit files for changes, so that on next obtainDataInterface() only changed
+        // directories are listed again and only changed files are re-read. Notifications are delivered only
+        // while thread that enabled watching runs Qt event loop
+        void setFileSystemWatchingEnabled(bool enabled);
+        bool isFileSystemWatchingEnabled() const;
+
+        // Marks all watched directories as changed, e.g. after files were added while watching is disabled
+        void invalidateSources();
+
         std::shared_ptr<ObfDataInterface> obtainDataInterface() const;
     };
 
@@ -28,6 +28,8 @@
 
 namespace OsmAnd {
 
+    class QueryStatistics;
+
     class OSMAND_CORE_API IQueryController
     {
     private:
@@ -37,6 +39,17 @@ namespace OsmAnd {
         virtual ~IQueryController();
 
         virtual bool isAborted() = 0;
+
+        //! Readers report each processed data block: how many objects it gave and how many bytes were read for it.
+        //! Query may be stopped by returning true from isAborted() afterwards. By default, reports are ignored
+        virtual void onBlockProcessed(const unsigned int objectsCount, const uint64_t bytesCount);
+
+        //! Returns true if query was stopped not by explicit abort, but since it ran out of budget.
+        //! Results of such query are incomplete, but still valid. By default, queries are never truncated
+        virtual bool isTruncated() const;
+
+        //! Statistics that readers fill in while processing query. By default, no statistics are collected
+        virtual QueryStatistics* getStatistics();
     };
 
 } // namespace OsmAnd
@@ -39,6 +39,7 @@ namespace OsmAnd {
 
     class MapStyleValueDefinition;
     class MapStyleRule;
+    class RasterizerEnvironment_P;
 
     union MapStyleValue
     {
@@ -95,6 +96,7 @@ namespace OsmAnd {
     friend class OsmAnd::MapStyle_P;
     friend class OsmAnd::MapStyleEvaluator;
     friend class OsmAnd::MapStyleRule;
+    friend class OsmAnd::RasterizerEnvironment_P;
     };
 
 } // namespace OsmAnd
@@ -63,6 +63,8 @@ namespace OsmAnd {
         void setIntegerValue(const std::shared_ptr<const MapStyleValueDefinition>& ref, const unsigned int& value);
         void setFloatValue(const std::shared_ptr<const MapStyleValueDefinition>& ref, const float& value);
         void setStringValue(const std::shared_ptr<const MapStyleValueDefinition>& ref, const QString& value);
+        //! Sets string value by its id, that was already resolved in this style
+        void setStringIdValue(const std::shared_ptr<const MapStyleValueDefinition>& ref, const uint32_t& stringId);
 
         bool getBooleanValue(const std::shared_ptr<const MapStyleValueDefinition>& ref, bool& value) const;
         bool getIntegerValue(const std::shared_ptr<const MapStyleValueDefinition>& ref, int& value) const;
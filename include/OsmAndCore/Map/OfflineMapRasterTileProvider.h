@@ -56,6 +56,10 @@ namespace OsmAnd {
         virtual uint32_t getTileSize() const;
 
         virtual bool obtainTile(const TileId& tileId, const ZoomLevel& zoom, std::shared_ptr<MapTile>& outTile);
+
+        //! Limits reading of map data for single tile. Once any limit is exceeded, tile is rasterized from
+        //! data read so far. Negative time limit, or zero limit of objects or bytes mean no limit (default)
+        void setDataQueryBudget(const int64_t timeLimitMs, const uint64_t maxObjects = 0, const uint64_t maxBytes = 0);
     };
 
 }
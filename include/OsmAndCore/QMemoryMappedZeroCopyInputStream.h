@@ -0,0 +1,99 @@
+/**
+ * @file
+ *
+ * @section LICENSE
+ *
+ * OsmAnd - Android navigation software based on OSM maps.
+ * Copyright (C) 2010-2013  OsmAnd Authors listed in AUTHORS file
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __Q_MEMORY_MAPPED_ZERO_COPY_INPUT_STREAM_H_
+#define __Q_MEMORY_MAPPED_ZERO_COPY_INPUT_STREAM_H_
+
+#include <memory>
+
+#include <QFile>
+
+#include <OsmAndCore.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+
+namespace OsmAnd {
+
+    namespace gpb = google::protobuf;
+
+    /**
+    Implementation of zero-copy input stream for Google Protobuf via memory-mapped QFile.
+    Entire file is mapped once, and pointers inside mapping are given to protobuf directly.
+    Since mapping is immutable, many streams (cursors) may read from it concurrently.
+    */
+    class OSMAND_CORE_API QMemoryMappedZeroCopyInputStream : public gpb::io::ZeroCopyInputStream
+    {
+    public:
+        //! Read-only mapping of entire file, that may be shared by many streams
+        class OSMAND_CORE_API Mapping
+        {
+            Q_DISABLE_COPY(Mapping)
+        private:
+            //! Pointer to file
+            const std::shared_ptr<QFile> _file;
+
+            //! Should close on destruction?
+            const bool _closeOnDestruction;
+
+            //! Mapped data
+            uchar* _data;
+            qint64 _size;
+        protected:
+        public:
+            Mapping(const std::shared_ptr<QFile>& file);
+            virtual ~Mapping();
+
+            uchar* const& data;
+            const qint64& size;
+
+            //! Returns true if file was mapped successfully
+            bool isMapped() const;
+        };
+    private:
+        GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(QMemoryMappedZeroCopyInputStream);
+
+        //! Current position inside mapped data
+        qint64 _position;
+    protected:
+    public:
+        //! Ctor, that maps file exclusively for this stream
+        QMemoryMappedZeroCopyInputStream(const std::shared_ptr<QFile>& file);
+
+        //! Ctor, that creates cursor over existing mapping
+        QMemoryMappedZeroCopyInputStream(const std::shared_ptr<const Mapping>& mapping);
+
+        //! Dtor
+        virtual ~QMemoryMappedZeroCopyInputStream();
+
+        const std::shared_ptr<const Mapping> mapping;
+
+        //! Returns true if file was mapped successfully, and stream is usable
+        bool isMapped() const;
+
+        virtual bool Next(const void** data, int* size);
+        virtual void BackUp(int count);
+        virtual bool Skip(int count);
+        virtual gpb::int64 ByteCount() const;
+    };
+
+} // namespace OsmAnd
+
+#endif // __Q_MEMORY_MAPPED_ZERO_COPY_INPUT_STREAM_H_
@@ -0,0 +1,85 @@
+/**
+* @file
+*
+* @section LICENSE
+*
+* OsmAnd - Android navigation software based on OSM maps.
+* Copyright (C) 2010-2013  OsmAnd Authors listed in AUTHORS file
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __QUERY_BUDGET_CONTROLLER_H_
+#define __QUERY_BUDGET_CONTROLLER_H_
+
+#include <cstdint>
+#include <memory>
+
+#include <QMutex>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+#include <OsmAndCore.h>
+#include <OsmAndCore/IQueryController.h>
+#include <OsmAndCore/QueryStatistics.h>
+
+namespace OsmAnd {
+
+    //! Query controller, that stops query once it runs out of time, objects or bytes budget.
+    //! Readers check it at data block granularity, so whatever was read before stop is a valid partial result,
+    //! and isTruncated() tells that it's partial.
+    class OSMAND_CORE_API QueryBudgetController : public IQueryController
+    {
+        Q_DISABLE_COPY(QueryBudgetController)
+    private:
+        QElapsedTimer _timer;
+
+        mutable QMutex _countersMutex;
+        uint64_t _objectsCount;
+        uint64_t _bytesCount;
+
+        QAtomicInt _isAborted;
+        QAtomicInt _isTruncated;
+
+        std::shared_ptr<QueryStatistics> _statistics;
+
+        void truncate();
+    protected:
+    public:
+        //! Time limit is counted from construction. Negative time limit, or zero limit of objects or bytes mean no limit
+        QueryBudgetController(const int64_t timeLimitMs, const uint64_t maxObjects = 0, const uint64_t maxBytes = 0);
+        virtual ~QueryBudgetController();
+
+        const int64_t timeLimitMs;
+        const uint64_t maxObjects;
+        const uint64_t maxBytes;
+
+        //! Stops query explicitly. Such query is not considered truncated
+        void abort();
+
+        uint64_t getObjectsCount() const;
+        uint64_t getBytesCount() const;
+
+        //! Statistics have to be attached before query starts. Budgets are applied without statistics too
+        void attachStatistics(const std::shared_ptr<QueryStatistics>& statistics);
+
+        virtual bool isAborted();
+        virtual void onBlockProcessed(const unsigned int objectsCount, const uint64_t bytesCount);
+        virtual bool isTruncated() const;
+        virtual QueryStatistics* getStatistics();
+    };
+
+} // namespace OsmAnd
+
+#endif // __QUERY_BUDGET_CONTROLLER_H_
@@ -0,0 +1,87 @@
+/**
+* @file
+*
+* @section LICENSE
+*
+* OsmAnd - Android navigation software based on OSM maps.
+* Copyright (C) 2010-2013  OsmAnd Authors listed in AUTHORS file
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __QUERY_STATISTICS_H_
+#define __QUERY_STATISTICS_H_
+
+#include <cstdint>
+
+#include <QMutex>
+#include <QElapsedTimer>
+
+#include <OsmAndCore.h>
+
+namespace OsmAnd {
+
+    //! Statistics of I/O and decoding, that section readers fill in if it's given by IQueryController::getStatistics().
+    //! Same instance may be shared by parallel queries, so readers accumulate counters locally and add them once per block.
+    class OSMAND_CORE_API QueryStatistics
+    {
+        Q_DISABLE_COPY(QueryStatistics)
+    public:
+        struct Counters
+        {
+            Counters();
+
+            uint64_t bytesRead;
+            uint64_t seeksCount;
+            uint64_t treeNodesVisited;
+            uint64_t blocksRead;
+            uint64_t objectsDecoded;
+            uint64_t objectsDiscarded;
+
+            //! Wall-clock times in nanoseconds. Block decoding time includes string table reading time
+            uint64_t treeTraversalTime;
+            uint64_t blocksDecodingTime;
+            uint64_t stringTablesReadingTime;
+
+            Counters& operator+=(const Counters& that);
+        };
+
+        //! Measures wall-clock time only if statistics are collected, otherwise does nothing
+        class OSMAND_CORE_API Stopwatch
+        {
+        private:
+            const bool _started;
+            QElapsedTimer _timer;
+        public:
+            Stopwatch(const bool start);
+
+            //! Returns nanoseconds elapsed since construction, or 0 if stopwatch was not started
+            uint64_t elapsed() const;
+        };
+    private:
+        mutable QMutex _mutex;
+        Counters _counters;
+    protected:
+    public:
+        QueryStatistics();
+        virtual ~QueryStatistics();
+
+        void add(const Counters& counters);
+        Counters get() const;
+        void reset();
+    };
+
+} // namespace OsmAnd
+
+#endif // __QUERY_STATISTICS_H_
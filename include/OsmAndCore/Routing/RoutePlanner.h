@@ -25,7 +25,6 @@
 
 #include <limits>
 #include <memory>
-#include <queue>
 #include <functional>
 
 #include <QString>
@@ -75,16 +74,13 @@ namespace OsmAnd {
     protected:
         RoutePlanner();
 
-        typedef std::priority_queue<
-            std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>,
-            std::vector< std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >,
-            std::function< bool(const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>&, const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>&) >
-        >  RoadSegmentsPriorityQueue;
+        typedef RoutePlannerContext::RouteCalculationSegmentsQueue RoadSegmentsPriorityQueue;
+        typedef RoutePlannerContext::RouteCalculationSegmentsVisitedMap VisitedSegmentsMap;
 
         static void loadRoads(RoutePlannerContext* context, uint32_t x31, uint32_t y31, uint32_t zoomAround, QList< std::shared_ptr<const Model::Road> >& roads);
         static void loadRoadsFromTile(RoutePlannerContext* context, uint64_t tileId, QList< std::shared_ptr<const Model::Road> >& roads);
         static uint64_t getRoutingTileId(RoutePlannerContext* context, uint32_t x31, uint32_t y31, bool dontLoad);
-        static uint32_t getCurrentEstimatedSize(RoutePlannerContext* context);
+        static size_t getCurrentEstimatedSize(RoutePlannerContext* context);
         static void cacheRoad(RoutePlannerContext* context, const std::shared_ptr<Model::Road>& road);
         static void loadTileHeader(RoutePlannerContext* context, uint32_t x31, uint32_t y31, QList< std::shared_ptr<RoutePlannerContext::RoutingSubsectionContext> >& subsectionsContexts);
         static void loadSubregionContext(RoutePlannerContext::RoutingSubsectionContext* context);
@@ -113,9 +109,9 @@ namespace OsmAnd {
             OsmAnd::RoutePlannerContext::CalculationContext* context,
             bool reverseWaySearch,
             RoadSegmentsPriorityQueue& graphSegments,
-            QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& visitedSegments,
+            VisitedSegmentsMap& visitedSegments,
             const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& segment,
-            QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& oppositeSegments,
+            VisitedSegmentsMap& oppositeSegments,
             bool forwardDirection);
         static float calculateTurnTime(
             OsmAnd::RoutePlannerContext::CalculationContext* context,
@@ -126,7 +122,7 @@ namespace OsmAnd {
         static bool checkIfInitialMovementAllowedOnSegment(
             OsmAnd::RoutePlannerContext::CalculationContext* context,
             bool reverseWaySearch,
-            QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& visitedSegments,
+            VisitedSegmentsMap& visitedSegments,
             const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& segment,
             bool forwardDirection,
             const std::shared_ptr<const Model::Road>& road);
@@ -135,7 +131,7 @@ namespace OsmAnd {
             bool reverseWaySearch,
             RoadSegmentsPriorityQueue& graphSegments,
             const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& segment,
-            QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& oppositeSegments,
+            VisitedSegmentsMap& oppositeSegments,
             const std::shared_ptr<const Model::Road>& road,
             uint32_t segmentEnd,
             bool forwardDirection,
@@ -156,7 +152,7 @@ namespace OsmAnd {
         static void processIntersections(
             OsmAnd::RoutePlannerContext::CalculationContext* context,
             RoadSegmentsPriorityQueue& graphSegments,
-            QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& visitedSegments,
+            VisitedSegmentsMap& visitedSegments,
             float distFromStart,
             const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& segment,
             uint32_t segmentEnd,
@@ -165,10 +161,10 @@ namespace OsmAnd {
             bool addSameRoadFutureDirection);
         static bool checkPartialRecalculationPossible(
             OsmAnd::RoutePlannerContext::CalculationContext* context,
-            QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& visitedOppositeSegments,
+            VisitedSegmentsMap& visitedOppositeSegments,
             std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& segment);
         static std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> loadRouteCalculationSegment(
-            OsmAnd::RoutePlannerContext* context,
+            OsmAnd::RoutePlannerContext::CalculationContext* context,
             uint32_t x31, uint32_t y31);
         static void printDebugInformation(OsmAnd::RoutePlannerContext::CalculationContext* ctx,
             int directSegmentSize, int reverseSegmentSize,
@@ -181,6 +177,14 @@ namespace OsmAnd {
             RoutePointsBitSpace = 11,
         };
 
+        // Expected number of visited segments per kilometer of straight distance between start and target,
+        // used to size visited segments maps up front. Size is capped low, since each map pre-allocates for it,
+        // and maps of longer searches grow on their own
+        enum {
+            ExpectedVisitedSegmentsPerKm = 200,
+            MaxExpectedVisitedSegments = 4096,
+        };
+
         static OsmAnd::RouteCalculationResult prepareResult(OsmAnd::RoutePlannerContext::CalculationContext* context,
             std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> finalSegment,
             bool leftSideNavigation);
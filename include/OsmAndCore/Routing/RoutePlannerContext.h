@@ -25,6 +25,7 @@
 
 #include <limits>
 #include <memory>
+#include <vector>
 
 #include <ctime>
 #include <chrono>
@@ -46,6 +47,7 @@
 namespace OsmAnd {
 
     class ObfReader;
+    class ObfDataInterface;
     class ObfRoutingSectionInfo;
     class ObfRoutingSubsectionInfo;
     class ObfRoutingBorderLinePoint;
@@ -78,6 +80,11 @@ namespace OsmAnd {
     class OSMAND_CORE_API RoutePlannerContext
     {
     public:
+        class RouteCalculationSegmentsQueue;
+        class RouteCalculationSegmentsVisitedMap;
+        class RouteCalculationSegmentsPool;
+        class CalculationContext;
+
         class OSMAND_CORE_API RouteCalculationSegment
         {
         private:
@@ -91,12 +98,24 @@ namespace OsmAnd {
 
             int _assignedDirection;
 
+            // Position in priority queue of search, while segment is queued
+            uint32_t _queueIndex;
+
+            // Final segment joins direct and reverse searches via opposite segment
+            bool _isFinal;
+            bool _reverseWaySearch;
+            std::shared_ptr<RouteCalculationSegment> _opposite;
+
             RouteCalculationSegment(const std::shared_ptr<const Model::Road>& road, uint32_t pointIndex);
 
             void dump(const QString& prefix = QString()) const;
         public:
             virtual ~RouteCalculationSegment();
 
+            enum : uint32_t {
+                NotQueued = 0xFFFFFFFFu,
+            };
+
             const std::shared_ptr<const Model::Road> road;
             const uint32_t pointIndex;
 
@@ -109,24 +128,90 @@ namespace OsmAnd {
 
             friend class OsmAnd::RoutePlanner;
             friend class OsmAnd::RoutePlannerContext;
+            friend class OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue;
+            friend class OsmAnd::RoutePlannerContext::CalculationContext;
         };
 
-        class OSMAND_CORE_API RouteCalculationFinalSegment : public RouteCalculationSegment
+        //! Priority queue of search: 4-ary heap of (priority, segment) entries. Each queued segment knows
+        //! its position in heap, so its priority can be changed in place instead of rebuilding entire queue
+        class OSMAND_CORE_API RouteCalculationSegmentsQueue
         {
         private:
+            struct Entry
+            {
+                double priority;
+                std::shared_ptr<RouteCalculationSegment> segment;
+            };
+            std::vector<Entry> _heap;
+            const double _heuristicCoefficient;
+
+            enum {
+                Arity = 4,
+            };
+
+            double getPriority(const RouteCalculationSegment* segment) const;
+            void siftUp(uint32_t index);
+            void siftDown(uint32_t index);
         protected:
-            RouteCalculationFinalSegment(const std::shared_ptr<const Model::Road>& road, uint32_t pointIndex);
-
-            bool _reverseWaySearch;
-            std::shared_ptr<RouteCalculationSegment> _opposite;
         public:
-            virtual ~RouteCalculationFinalSegment();
-
-            const bool& reverseWaySearch;
-            const std::shared_ptr<RouteCalculationSegment>& opposite;
+            RouteCalculationSegmentsQueue(const double heuristicCoefficient);
+            ~RouteCalculationSegmentsQueue();
+
+            bool empty() const;
+            size_t size() const;
+            const std::shared_ptr<RouteCalculationSegment>& top() const;
+            //! Segments in heap order, not in priority order
+            const std::shared_ptr<RouteCalculationSegment>& at(const size_t index) const;
+            bool contains(const std::shared_ptr<RouteCalculationSegment>& segment) const;
+
+            size_t getConsumedMemory() const;
+
+            void push(const std::shared_ptr<RouteCalculationSegment>& segment);
+            void pop();
+            //! Restores order once distances of segment were changed. Segment, that is not queued, is pushed
+            void update(const std::shared_ptr<RouteCalculationSegment>& segment);
+        };
 
-            friend class OsmAnd::RoutePlanner;
-            friend class OsmAnd::RoutePlannerContext;
+        //! Visited segments of search, keyed by RoutePlanner::encodeRoutePointId(). Open-addressing hash table
+        //! with linear probing: ids and segments are stored inline, so lookup touches one or two cache lines.
+        //! Segments are never removed from it, only cleared all at once
+        class OSMAND_CORE_API RouteCalculationSegmentsVisitedMap
+        {
+        private:
+            // Slot without segment is free
+            struct Slot
+            {
+                uint64_t id;
+                std::shared_ptr<RouteCalculationSegment> segment;
+            };
+            std::vector<Slot> _slots;
+            unsigned int _capacityBits;
+            size_t _size;
+
+            enum {
+                MinCapacityBits = 10,
+            };
+
+            size_t findSlot(const uint64_t id) const;
+            void rehash(const unsigned int capacityBits);
+        protected:
+        public:
+            RouteCalculationSegmentsVisitedMap(const size_t expectedSize = 0);
+            ~RouteCalculationSegmentsVisitedMap();
+
+            size_t size() const;
+            bool isEmpty() const;
+            size_t getConsumedMemory() const;
+            //! Allocates slots for given number of segments, so that they're inserted without rehashing
+            void reserve(const size_t expectedSize);
+            //! Releases all segments, but keeps slots allocated
+            void clear();
+
+            bool contains(const uint64_t id) const;
+            //! Returns empty pointer if there is no segment with given id
+            const std::shared_ptr<RouteCalculationSegment>& value(const uint64_t id) const;
+            //! Replaces segment, if there was one with given id
+            void insert(const uint64_t id, const std::shared_ptr<RouteCalculationSegment>& segment);
         };
 
         class OSMAND_CORE_API RoutingSubsectionContext
@@ -134,14 +219,21 @@ namespace OsmAnd {
         private:
             int _mixedLoadsCounter;
             int _access;
+            // Value of owner's access clock at last access
+            uint64_t _lastAccessTime;
         protected:
             RoutingSubsectionContext(RoutePlannerContext* owner, const std::shared_ptr<ObfReader>& origin, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection);
 
             QMap< uint64_t, std::shared_ptr<RouteCalculationSegment> > _roadSegments;
+            // Approximate memory consumed by registered roads and their segments, in bytes
+            size_t _consumedMemory;
+            // Decoded roads are immutable and shared with other contexts, while segments are owned by this context
+            std::shared_ptr< const QList< std::shared_ptr<const Model::Road> > > _sharedRoads;
 
             void markLoaded();
             void unload();
-            std::shared_ptr<RouteCalculationSegment> loadRouteCalculationSegment(uint32_t x31, uint32_t y31, QMap<uint64_t, std::shared_ptr<const Model::Road> >& processed, const std::shared_ptr<RouteCalculationSegment>& original);
+            std::shared_ptr<RouteCalculationSegment> loadRouteCalculationSegment(CalculationContext* calculationContext,
+                uint32_t x31, uint32_t y31, QMap<uint64_t, std::shared_ptr<const Model::Road> >& processed, const std::shared_ptr<RouteCalculationSegment>& original);
         public:
             virtual ~RoutingSubsectionContext();
 
@@ -178,11 +270,19 @@ namespace OsmAnd {
             
             QList< std::shared_ptr<BorderLine> > _borderLines;
             QVector< uint32_t > _borderLinesY31;
+
+            // Segments of single calculation reuse memory of segments, that were already discarded. Pool has
+            // to outlive all segments it gave out, so none of them may be kept once calculation is over
+            std::unique_ptr<RouteCalculationSegmentsPool> _segmentsPool;
+            std::shared_ptr<RouteCalculationSegment> allocateSegment(const std::shared_ptr<const Model::Road>& road, uint32_t pointIndex);
             
             CalculationContext(RoutePlannerContext* owner);
         public:
             virtual ~CalculationContext();
 
+            //! Memory consumed by segments created during calculation, in bytes
+            size_t getConsumedMemory() const;
+
             RoutePlannerContext* const owner;
 
             friend class OsmAnd::RoutePlanner;
@@ -202,6 +302,15 @@ namespace OsmAnd {
         float _initialHeading;
         bool _useBasemap;
         size_t _memoryUsageLimit;
+        // Approximate memory consumed by loaded subsections and by running search, in bytes
+        size_t _roadsConsumedMemory;
+        size_t _searchConsumedMemory;
+
+        // Ticks on each access to subsection, to order subsections by recency of use
+        uint64_t _accessClock;
+        // Priority queues of running search, registered by RoutePlanner::calculateRoute() only while it runs
+        QList<const RouteCalculationSegmentsQueue*> _searchFrontiers;
+        static bool isLessValuableSubsection(const std::shared_ptr<RoutingSubsectionContext>& l, const std::shared_ptr<RoutingSubsectionContext>& r);
         uint32_t _roadTilesLoadingZoomLevel;
         int _planRoadDirection;
         float _heuristicCoefficient;
@@ -211,6 +320,7 @@ namespace OsmAnd {
 
         enum {
             DefaultRoadTilesLoadingZoomLevel = 16,
+            DefaultMemoryUsageLimit = 256 * 1024 * 1024,
         };
     public:
         RoutePlannerContext(
@@ -220,15 +330,19 @@ namespace OsmAnd {
             bool useBasemap,
             float initialHeading = std::numeric_limits<float>::quiet_NaN(),
             QHash<QString, QString>* options = nullptr,
-            size_t memoryLimit = 1000000);
+            size_t memoryLimit = DefaultMemoryUsageLimit,
+            const std::shared_ptr<OsmAnd::ObfDataInterface>& dataInterface = nullptr);
         virtual ~RoutePlannerContext();
 
         const QList< std::shared_ptr<OsmAnd::ObfReader> > sources;
+        // If set, it must be obtained over same files as sources. Used to find routing subsections without visiting every source
+        const std::shared_ptr<OsmAnd::ObfDataInterface> dataInterface;
         const std::shared_ptr<OsmAnd::RoutingConfiguration> configuration;
         const std::shared_ptr<OsmAnd::RoutingProfileContext> profileContext;
 
         uint32_t getCurrentlyLoadedTiles();
-        uint32_t getCurrentEstimatedSize();
+        //! Approximate memory consumed by context, in bytes. Memory limit of context is compared to it
+        size_t getCurrentEstimatedSize() const;
         void unloadUnusedTiles(size_t memoryTarget);
 
         friend class OsmAnd::RoutePlanner;
@@ -1,19 +1,20 @@
 #include "MapObject.h"
 
 #include "ObfMapSectionReader.h"
+#include "ObfStringTable.h"
 
-OsmAnd::Model::MapObject::MapObject(const std::shared_ptr<const ObfMapSectionInfo>& section_)
+OsmAnd::Model::MapObject::MapObject(const std::shared_ptr<const ObfMapSectionInfo>& section_, const std::shared_ptr<const EncodingDecodingRules>& rules_)
     : _id(std::numeric_limits<uint64_t>::max())
     , _foundation(MapFoundationType::Undefined)
     , section(section_)
+    , rules(rules_)
     , id(_id)
     , isArea(_isArea)
     , points31(_points31)
     , innerPolygonsPoints31(_innerPolygonsPoints31)
-    , types(_types)
-    , extraTypes(_extraTypes)
+    , typesRuleIds(_typesRuleIds)
+    , extraTypesRuleIds(_extraTypesRuleIds)
     , foundation(_foundation)
-    , names(_names)
     , bbox31(_bbox31)
 {
 }
@@ -22,34 +23,85 @@ OsmAnd::Model::MapObject::~MapObject()
 {
 }
 
+const OsmAnd::TagValue& OsmAnd::Model::MapObject::getType( int typeIndex ) const
+{
+    return rules->decodeRule(_typesRuleIds[typeIndex]);
+}
+
+const OsmAnd::TagValue& OsmAnd::Model::MapObject::getExtraType( int typeIndex ) const
+{
+    return rules->decodeRule(_extraTypesRuleIds[typeIndex]);
+}
+
+bool OsmAnd::Model::MapObject::hasNames() const
+{
+    return !_namesIds.isEmpty();
+}
+
+QHash<QString, QString> OsmAnd::Model::MapObject::getNames() const
+{
+    QHash<QString, QString> names;
+    if(!_stringTable)
+        return names;
+
+    names.reserve(_namesIds.size());
+    for(auto itNameId = _namesIds.cbegin(); itNameId != _namesIds.cend(); ++itNameId)
+    {
+        const auto& nameId = *itNameId;
+        names.insert(rules->decodeRule(nameId.first).tag, _stringTable->getString(nameId.second));
+    }
+    return names;
+}
+
+int OsmAnd::Model::MapObject::getNamesCount() const
+{
+    return _stringTable ? _namesIds.size() : 0;
+}
+
+const QString& OsmAnd::Model::MapObject::getNameTag( int nameIndex ) const
+{
+    return rules->decodeRule(_namesIds[nameIndex].first).tag;
+}
+
+QString OsmAnd::Model::MapObject::getName( int nameIndex ) const
+{
+    if(!_stringTable)
+        return QString();
+    return _stringTable->getString(_namesIds[nameIndex].second);
+}
+
+QString OsmAnd::Model::MapObject::getNameByTag( const QString& tag ) const
+{
+    if(!_stringTable)
+        return QString();
+
+    for(auto itNameId = _namesIds.cbegin(); itNameId != _namesIds.cend(); ++itNameId)
+    {
+        const auto& nameId = *itNameId;
+        if(rules->decodeRule(nameId.first).tag == tag)
+            return _stringTable->getString(nameId.second);
+    }
+    return QString();
+}
+
 int OsmAnd::Model::MapObject::getSimpleLayerValue() const
 {
     auto isTunnel = false;
     auto isBridge = false;
-    for(auto itType = _extraTypes.begin(); itType != _extraTypes.end(); ++itType)
+    for(auto itTypeRuleId = _extraTypesRuleIds.begin(); itTypeRuleId != _extraTypesRuleIds.end(); ++itTypeRuleId)
     {
-        const auto& type = *itType;
+        const auto ruleFlags = rules->getRuleFlags(*itTypeRuleId);
 
-        if (type.tag == QLatin1String("layer"))
-        {
-            if(!type.value.isEmpty())
-            {
-                if(type.value[0] == '-')
-                    return -1;
-                else if (type.value[0] == '0')
-                    return 0;
-                else
-                    return 1;
-            }
-        }
-        else if (type.tag == QLatin1String("tunnel"))
-        {
-            isTunnel = (type.value == QLatin1String("yes"));
-        }
-        else if (type.tag == QLatin1String("bridge"))
-        {
-            isBridge = (type.value == QLatin1String("yes"));
-        }
+        if(ruleFlags & EncodingDecodingRules::IsNegativeLayer)
+            return -1;
+        else if(ruleFlags & EncodingDecodingRules::IsZeroLayer)
+            return 0;
+        else if(ruleFlags & EncodingDecodingRules::IsPositiveLayer)
+            return 1;
+        else if(ruleFlags & EncodingDecodingRules::IsTunnel)
+            isTunnel = (ruleFlags & EncodingDecodingRules::HasYesValue) != 0;
+        else if(ruleFlags & EncodingDecodingRules::IsBridge)
+            isBridge = (ruleFlags & EncodingDecodingRules::HasYesValue) != 0;
     }
 
     if (isTunnel)
@@ -81,11 +133,21 @@ bool OsmAnd::Model::MapObject::isClosedFigure(bool checkInner /*= false*/) const
 
 bool OsmAnd::Model::MapObject::containsType( const QString& tag, const QString& value, bool checkAdditional /*= false*/ ) const
 {
-    const auto& types = (checkAdditional ? _extraTypes : _types);
-    for(auto itType = types.begin(); itType != types.end(); ++itType)
+    // Compare rule ids instead of strings
+    uint32_t ruleId;
+    if(!rules->lookupRuleId(tag, value, ruleId))
+        return false;
+
+    const auto& typesRuleIds = (checkAdditional ? _extraTypesRuleIds : _typesRuleIds);
+    return typesRuleIds.contains(ruleId);
+}
+
+bool OsmAnd::Model::MapObject::containsTypeWithFlag( const uint32_t ruleFlag, bool checkAdditional /*= false*/ ) const
+{
+    const auto& typesRuleIds = (checkAdditional ? _extraTypesRuleIds : _typesRuleIds);
+    for(auto itTypeRuleId = typesRuleIds.cbegin(); itTypeRuleId != typesRuleIds.cend(); ++itTypeRuleId)
     {
-        const auto& type = *itType;
-        if(type.tag == tag && type.value == value)
+        if(rules->getRuleFlags(*itTypeRuleId) & ruleFlag)
             return true;
     }
     return false;
@@ -94,6 +156,8 @@ bool OsmAnd::Model::MapObject::containsType( const QString& tag, const QString&
 size_t OsmAnd::Model::MapObject::calculateApproxConsumedMemory() const
 {
     size_t res = sizeof(MapObject) + _points31.size() * sizeof(PointI);
+    res += (_typesRuleIds.size() + _extraTypesRuleIds.size()) * sizeof(uint32_t);
+    res += _namesIds.size() * sizeof(QPair<uint32_t, uint32_t>);
     for(auto itPolygon = _innerPolygonsPoints31.begin(); itPolygon != _innerPolygonsPoints31.end(); ++itPolygon)
     {
         const auto& polygon = *itPolygon;
@@ -102,3 +166,89 @@ size_t OsmAnd::Model::MapObject::calculateApproxConsumedMemory() const
     }
     return res;
 }
+
+OsmAnd::Model::MapObject::EncodingDecodingRules::DecodingRule::DecodingRule()
+    : flags(0)
+{
+}
+
+OsmAnd::Model::MapObject::EncodingDecodingRules::EncodingDecodingRules()
+    : decodingRulesCount(0)
+{
+}
+
+OsmAnd::Model::MapObject::EncodingDecodingRules::~EncodingDecodingRules()
+{
+}
+
+void OsmAnd::Model::MapObject::EncodingDecodingRules::addRule( uint32_t ruleId, const QString& tag, const QString& value )
+{
+    auto itEncodingRule = encodingRules.find(tag);
+    if(itEncodingRule == encodingRules.end())
+        itEncodingRule = encodingRules.insert(tag, QHash<QString, uint32_t>());
+    itEncodingRule->insert(value, ruleId);
+
+    if(ruleId >= static_cast<uint32_t>(decodingRules.size()))
+        decodingRules.resize(ruleId + 1);
+    auto& decodingRule = decodingRules[ruleId];
+    if(decodingRule.flags & IsDefined)
+        return;
+    decodingRulesCount++;
+
+    decodingRule.tagValue = TagValue(tag, value);
+    decodingRule.flags = IsDefined;
+    if(value == QLatin1String("yes"))
+        decodingRule.flags |= HasYesValue;
+    if(tag == QLatin1String("name"))
+        decodingRule.flags |= IsName;
+    else if(tag == QLatin1String("natural") && value == QLatin1String("coastline"))
+        decodingRule.flags |= IsCoastline;
+    else if(tag == QLatin1String("oneway") && value == QLatin1String("yes"))
+        decodingRule.flags |= IsOneway;
+    else if(tag == QLatin1String("oneway") && value == QLatin1String("-1"))
+        decodingRule.flags |= IsOnewayReverse;
+    else if(tag == QLatin1String("tunnel"))
+        decodingRule.flags |= IsTunnel;
+    else if(tag == QLatin1String("bridge"))
+        decodingRule.flags |= IsBridge;
+    else if(tag == QLatin1String("layer") && !value.isEmpty())
+    {
+        if(value[0] == '-')
+            decodingRule.flags |= IsNegativeLayer;
+        else if(value[0] == '0')
+            decodingRule.flags |= IsZeroLayer;
+        else
+            decodingRule.flags |= IsPositiveLayer;
+    }
+}
+
+bool OsmAnd::Model::MapObject::EncodingDecodingRules::lookupRuleId( const QString& tag, const QString& value, uint32_t& outRuleId ) const
+{
+    const auto itEncodingRule = encodingRules.constFind(tag);
+    if(itEncodingRule == encodingRules.cend())
+        return false;
+
+    const auto itRuleId = itEncodingRule->constFind(value);
+    if(itRuleId == itEncodingRule->cend())
+        return false;
+
+    outRuleId = *itRuleId;
+    return true;
+}
+
+const OsmAnd::TagValue& OsmAnd::Model::MapObject::EncodingDecodingRules::decodeRule( uint32_t ruleId ) const
+{
+    static const TagValue unknownRule;
+
+    // Ids that were never added hold empty tag-value, same as unknown rule
+    if(ruleId >= static_cast<uint32_t>(decodingRules.size()))
+        return unknownRule;
+    return decodingRules[ruleId].tagValue;
+}
+
+uint32_t OsmAnd::Model::MapObject::EncodingDecodingRules::getRuleFlags( uint32_t ruleId ) const
+{
+    if(ruleId >= static_cast<uint32_t>(decodingRules.size()))
+        return 0;
+    return decodingRules[ruleId].flags;
+}
@@ -4,12 +4,12 @@
 
 #include "ObfRoutingSectionInfo.h"
 #include "ObfRoutingSectionInfo_P.h"
+#include "ObfStringTable.h"
 #include "Utilities.h"
 
 OsmAnd::Model::Road::Road(const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection)
     : subsection(subsection)
     , id(_id)
-    , names(_names)
     , points(_points)
     , types(_types)
     , pointsTypes(_pointsTypes)
@@ -20,10 +20,11 @@ OsmAnd::Model::Road::Road(const std::shared_ptr<const ObfRoutingSubsectionInfo>&
 OsmAnd::Model::Road::Road( const std::shared_ptr<const Road>& that, int insertIdx, uint32_t x31, uint32_t y31 )
     : _ref(that)
     , _id(0)
+    , _namesIds(_ref->_namesIds)
+    , _stringTable(_ref->_stringTable)
     , _points(_ref->_points.size() + 1)
     , subsection(_ref->subsection)
     , id(_ref->_id)
-    , names(_ref->_names)
     , points(_points)
     , types(_ref->_types)
     , pointsTypes(_pointsTypes)
@@ -49,6 +50,33 @@ OsmAnd::Model::Road::~Road()
 {
 }
 
+bool OsmAnd::Model::Road::hasNames() const
+{
+    return !_namesIds.isEmpty();
+}
+
+QMap<uint32_t, QString> OsmAnd::Model::Road::getNames() const
+{
+    QMap<uint32_t, QString> names;
+    if(!_stringTable)
+        return names;
+
+    for(auto itNameId = _namesIds.cbegin(); itNameId != _namesIds.cend(); ++itNameId)
+        names.insert(itNameId.key(), _stringTable->getString(itNameId.value()));
+    return names;
+}
+
+QString OsmAnd::Model::Road::getNameByTag( uint32_t tagRuleId ) const
+{
+    if(!_stringTable)
+        return QString();
+
+    const auto itNameId = _namesIds.constFind(tagRuleId);
+    if(itNameId == _namesIds.cend())
+        return QString();
+    return _stringTable->getString(itNameId.value());
+}
+
 double OsmAnd::Model::Road::getDirectionDelta( uint32_t originIdx, bool forward ) const
 {
     //NOTE: Victor: the problem to put more than 5 meters that BinaryRoutePlanner will treat
@@ -147,3 +175,13 @@ bool OsmAnd::Model::Road::isLoop() const
 
     return _points.first() == _points.last();
 }
+
+size_t OsmAnd::Model::Road::calculateApproxConsumedMemory() const
+{
+    size_t res = sizeof(Road) + _points.size() * sizeof(PointI) + _types.size() * sizeof(uint32_t);
+    res += _namesIds.size() * sizeof(QPair<uint32_t, uint32_t>);
+    for(auto itPointTypes = _pointsTypes.cbegin(); itPointTypes != _pointsTypes.cend(); ++itPointTypes)
+        res += sizeof(uint32_t) + itPointTypes->size() * sizeof(uint32_t);
+    res += _restrictions.size() * (sizeof(uint64_t) + sizeof(RoadRestriction));
+    return res;
+}
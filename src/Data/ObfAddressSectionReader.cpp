@@ -2,6 +2,7 @@
 #include "ObfAddressSectionReader_P.h"
 
 #include "ObfReader.h"
+#include "ObfReader_P.h"
 
 OsmAnd::ObfAddressSectionReader::ObfAddressSectionReader()
 {
@@ -17,7 +18,8 @@ void OsmAnd::ObfAddressSectionReader::loadStreetGroups(
     std::function<bool (const std::shared_ptr<const OsmAnd::Model::StreetGroup>&)> visitor /*= nullptr*/,
     IQueryController* controller /*= nullptr*/, QSet<ObfAddressBlockType>* blockTypeFilter /*= nullptr*/ )
 {
-    ObfAddressSectionReader_P::loadStreetGroups(reader->_d, section, resultOut, visitor, controller, blockTypeFilter);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfAddressSectionReader_P::loadStreetGroups(cursor.reader(), section, resultOut, visitor, controller, blockTypeFilter);
 }
 
 void OsmAnd::ObfAddressSectionReader::loadStreetsFromGroup(
@@ -25,7 +27,8 @@ void OsmAnd::ObfAddressSectionReader::loadStreetsFromGroup(
     QList< std::shared_ptr<const Model::Street> >* resultOut /*= nullptr*/,
     std::function<bool (const std::shared_ptr<const OsmAnd::Model::Street>&)> visitor /*= nullptr*/, IQueryController* controller /*= nullptr*/ )
 {
-    ObfAddressSectionReader_P::loadStreetsFromGroup(reader->_d, group, resultOut, visitor, controller);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfAddressSectionReader_P::loadStreetsFromGroup(cursor.reader(), group, resultOut, visitor, controller);
 }
 
 void OsmAnd::ObfAddressSectionReader::loadBuildingsFromStreet(
@@ -33,7 +36,8 @@ void OsmAnd::ObfAddressSectionReader::loadBuildingsFromStreet(
     QList< std::shared_ptr<const Model::Building> >* resultOut /*= nullptr*/,
     std::function<bool (const std::shared_ptr<const OsmAnd::Model::Building>&)> visitor /*= nullptr*/, IQueryController* controller /*= nullptr*/ )
 {
-    ObfAddressSectionReader_P::loadBuildingsFromStreet(reader->_d, street, resultOut, visitor, controller);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfAddressSectionReader_P::loadBuildingsFromStreet(cursor.reader(), street, resultOut, visitor, controller);
 }
 
 void OsmAnd::ObfAddressSectionReader::loadIntersectionsFromStreet(
@@ -41,5 +45,6 @@ void OsmAnd::ObfAddressSectionReader::loadIntersectionsFromStreet(
     QList< std::shared_ptr<const Model::StreetIntersection> >* resultOut /*= nullptr*/,
     std::function<bool (const std::shared_ptr<const OsmAnd::Model::StreetIntersection>&)> visitor /*= nullptr*/, IQueryController* controller /*= nullptr*/ )
 {
-    ObfAddressSectionReader_P::loadIntersectionsFromStreet(reader->_d, street, resultOut, visitor, controller);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfAddressSectionReader_P::loadIntersectionsFromStreet(cursor.reader(), street, resultOut, visitor, controller);
 }
@@ -4,10 +4,18 @@
 #include "ObfReader.h"
 #include "ObfInfo.h"
 #include "ObfMapSectionReader.h"
+#include "ObfRoutingSectionInfo.h"
+#include "ObfRoutingSectionReader.h"
+#include "ObfPoiSectionInfo.h"
+#include "ObfPoiSectionReader.h"
+#include "PlainQueryFilter.h"
+#include "ObfSectionsSpatialIndex.h"
 #include "IQueryController.h"
+#include "Utilities.h"
 
-OsmAnd::ObfDataInterface::ObfDataInterface( const QList< std::shared_ptr<ObfReader> >& readers )
-    : _d(new ObfDataInterface_P(this, readers))
+OsmAnd::ObfDataInterface::ObfDataInterface( const QList< std::shared_ptr<ObfReader> >& readers,
+    const std::shared_ptr<const ObfSectionsSpatialIndex>& spatialIndex /*= nullptr*/ )
+    : _d(new ObfDataInterface_P(this, readers, spatialIndex))
 {
 }
 
@@ -46,30 +54,146 @@ void OsmAnd::ObfDataInterface::obtainBasemapPresenceFlag( bool& basemapPresent,
     }
 }
 
+void OsmAnd::ObfDataInterface::setParallelMapObjectsLoading( const bool enabled )
+{
+    _d->_parallelMapObjectsLoading = enabled;
+}
+
+bool OsmAnd::ObfDataInterface::isParallelMapObjectsLoadingEnabled() const
+{
+    return _d->_parallelMapObjectsLoading;
+}
+
 void OsmAnd::ObfDataInterface::obtainMapObjects( QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut, MapFoundationType* foundationOut, const AreaI& area31, const ZoomLevel& zoom, IQueryController* controller /*= nullptr*/ )
 {
     if(foundationOut)
         *foundationOut = MapFoundationType::Undefined;
 
-    // Iterate through all OBF readers
-    for(auto itObfReader = _d->readers.begin(); itObfReader != _d->readers.end(); ++itObfReader)
+    if(_d->_parallelMapObjectsLoading)
+    {
+        _d->loadMapObjectsInParallel(resultOut, foundationOut, area31, zoom, controller);
+        return;
+    }
+
+    // Find map sections of all OBF readers, that may have data for this query
+    QList<ObfDataInterface_P::MapSectionEntry> mapSections;
+    if(!_d->obtainMapSections(area31, zoom, mapSections, controller))
+        return;
+
+    for(auto itMapSection = mapSections.cbegin(); itMapSection != mapSections.cend(); ++itMapSection)
     {
         // Check if request is aborted
         if(controller && controller->isAborted())
             return;
 
-        // Iterate over all map sections of each OBF reader
-        const auto& obfReader = *itObfReader;
-        const auto& obfInfo = obfReader->obtainInfo();
-        for(auto itMapSection = obfInfo->mapSections.begin(); itMapSection != obfInfo->mapSections.end(); ++itMapSection)
-        {
-            // Check if request is aborted
-            if(controller && controller->isAborted())
-                return;
-
-            // Read objects from each map section
-            const auto& mapSection = *itMapSection;
-            OsmAnd::ObfMapSectionReader::loadMapObjects(obfReader, mapSection, zoom, &area31, resultOut, foundationOut, nullptr, controller);
-        }
+        // Read objects from each map section
+        const auto& obfReader = itMapSection->first;
+        const auto& mapSection = itMapSection->second;
+        OsmAnd::ObfMapSectionReader::loadMapObjects(obfReader, mapSection, zoom, &area31, resultOut, foundationOut, nullptr, controller);
+    }
+}
+
+void OsmAnd::ObfDataInterface::obtainMapObjectsForTiles( QVector< QList< std::shared_ptr<const OsmAnd::Model::MapObject> > >* resultsOut, QVector<MapFoundationType>* foundationsOut,
+    const QList<TileId>& tileIds, const ZoomLevel& zoom, IQueryController* controller /*= nullptr*/ )
+{
+    if(resultsOut)
+    {
+        resultsOut->clear();
+        resultsOut->resize(tileIds.size());
+    }
+    if(foundationsOut)
+        foundationsOut->fill(MapFoundationType::Undefined, tileIds.size());
+    if(tileIds.isEmpty())
+        return;
+
+    QVector<AreaI> tilesAreas31;
+    tilesAreas31.reserve(tileIds.size());
+    auto unitedArea31 = Utilities::tileBoundingBox31(tileIds.first(), zoom);
+    for(auto itTileId = tileIds.cbegin(); itTileId != tileIds.cend(); ++itTileId)
+    {
+        const auto tileArea31 = Utilities::tileBoundingBox31(*itTileId, zoom);
+        tilesAreas31.push_back(tileArea31);
+
+        unitedArea31.top = qMin(unitedArea31.top, tileArea31.top);
+        unitedArea31.left = qMin(unitedArea31.left, tileArea31.left);
+        unitedArea31.bottom = qMax(unitedArea31.bottom, tileArea31.bottom);
+        unitedArea31.right = qMax(unitedArea31.right, tileArea31.right);
+    }
+
+    // Sections are selected once for all tiles
+    QList<ObfDataInterface_P::MapSectionEntry> mapSections;
+    if(!_d->obtainMapSections(unitedArea31, zoom, mapSections, controller))
+        return;
+
+    for(auto itMapSection = mapSections.cbegin(); itMapSection != mapSections.cend(); ++itMapSection)
+    {
+        // Check if request is aborted
+        if(controller && controller->isAborted())
+            return;
+
+        // Results of each section are appended to results of previous ones, while foundations are merged by reader
+        const auto& obfReader = itMapSection->first;
+        const auto& mapSection = itMapSection->second;
+        QVector< QList< std::shared_ptr<const OsmAnd::Model::MapObject> > > sectionResults;
+        OsmAnd::ObfMapSectionReader::loadMapObjectsForAreas(obfReader, mapSection, zoom, tilesAreas31,
+            resultsOut ? &sectionResults : nullptr, foundationsOut, controller);
+
+        if(!resultsOut)
+            continue;
+        for(auto tileIdx = 0; tileIdx < sectionResults.size(); tileIdx++)
+            (*resultsOut)[tileIdx].append(sectionResults[tileIdx]);
+    }
+}
+
+void OsmAnd::ObfDataInterface::obtainRoutingSubsections( QList< std::pair< std::shared_ptr<ObfReader>, std::shared_ptr<const ObfRoutingSubsectionInfo> > >* resultOut,
+    const AreaI& area31, const bool basemap, IQueryController* controller /*= nullptr*/ )
+{
+    // Routing sections are indexed by their root subsections, regardless of zoom
+    QList<ObfDataInterface_P::SectionEntry> routingSections;
+    if(!_d->obtainSections(area31, ObfSectionsSpatialIndex::RoutingSection, nullptr, routingSections, controller))
+        return;
+
+    PlainQueryFilter filter(nullptr, &area31);
+    for(auto itRoutingSection = routingSections.cbegin(); itRoutingSection != routingSections.cend(); ++itRoutingSection)
+    {
+        // Check if request is aborted
+        if(controller && controller->isAborted())
+            return;
+
+        const auto& obfReader = itRoutingSection->first;
+        const auto routingSection = std::static_pointer_cast<const ObfRoutingSectionInfo>(itRoutingSection->second);
+        OsmAnd::ObfRoutingSectionReader::querySubsections(
+            obfReader,
+            basemap ? routingSection->baseSubsections : routingSection->subsections,
+            nullptr,
+            &filter,
+            [&](const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection)
+            {
+                if(!subsection->containsData())
+                    return false;
+
+                if(resultOut)
+                    resultOut->push_back(std::make_pair(obfReader, subsection));
+                return true;
+            }
+        );
+    }
+}
+
+void OsmAnd::ObfDataInterface::obtainAmenities( QList< std::shared_ptr<const OsmAnd::Model::Amenity> >* resultOut, const AreaI& area31, const ZoomLevel& zoom, IQueryController* controller /*= nullptr*/ )
+{
+    QList<ObfDataInterface_P::SectionEntry> poiSections;
+    if(!_d->obtainSections(area31, ObfSectionsSpatialIndex::PoiSection, &zoom, poiSections, controller))
+        return;
+
+    for(auto itPoiSection = poiSections.cbegin(); itPoiSection != poiSections.cend(); ++itPoiSection)
+    {
+        // Check if request is aborted
+        if(controller && controller->isAborted())
+            return;
+
+        const auto& obfReader = itPoiSection->first;
+        const auto poiSection = std::static_pointer_cast<const ObfPoiSectionInfo>(itPoiSection->second);
+        OsmAnd::ObfPoiSectionReader::loadAmenities(obfReader, poiSection, zoom, 3, &area31, nullptr, resultOut, nullptr, controller);
     }
 }
@@ -1,12 +1,249 @@
 #include "ObfDataInterface_P.h"
 #include "ObfDataInterface.h"
 
-OsmAnd::ObfDataInterface_P::ObfDataInterface_P( ObfDataInterface* owner_, const QList< std::shared_ptr<ObfReader> >& readers_ )
+#include <algorithm>
+
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+#include "ObfReader.h"
+#include "ObfFile.h"
+#include "ObfInfo.h"
+#include "ObfMapSectionInfo.h"
+#include "ObfRoutingSectionInfo.h"
+#include "ObfPoiSectionInfo.h"
+#include "ObfMapSectionReader.h"
+#include "ObfSectionsSpatialIndex.h"
+#include "IQueryController.h"
+#include "Concurrent.h"
+
+OsmAnd::ObfDataInterface_P::ObfDataInterface_P( ObfDataInterface* owner_, const QList< std::shared_ptr<ObfReader> >& readers_,
+    const std::shared_ptr<const ObfSectionsSpatialIndex>& spatialIndex_ )
     : owner(owner_)
     , readers(readers_)
+    , spatialIndex(spatialIndex_)
+    , _parallelMapObjectsLoading(false)
 {
+    for(auto readerIdx = 0; readerIdx < readers.size(); readerIdx++)
+    {
+        const auto& obfFile = readers[readerIdx]->obfFile;
+        if(obfFile)
+            _readersIndices.insert(obfFile.get(), readerIdx);
+    }
 }
 
 OsmAnd::ObfDataInterface_P::~ObfDataInterface_P()
 {
 }
+
+namespace OsmAnd {
+    namespace ObfDataInterface_P_Internal {
+
+        struct MapObjectsLoadingJob
+        {
+            MapObjectsLoadingJob()
+                : foundation(MapFoundationType::Undefined)
+            {
+            }
+
+            std::shared_ptr<ObfReader> reader;
+            std::shared_ptr<const ObfMapSectionInfo> section;
+
+            QList< std::shared_ptr<const OsmAnd::Model::MapObject> > result;
+            MapFoundationType foundation;
+        };
+
+        struct MapObjectsLoadingState
+        {
+            MapObjectsLoadingState(const AreaI& area31_, const ZoomLevel zoom_, IQueryController* controller_, const bool collectResult_)
+                : area31(area31_)
+                , zoom(zoom_)
+                , controller(controller_)
+                , collectResult(collectResult_)
+                , nextJobIndex(0)
+                , finishedJobsCount(0)
+            {
+            }
+
+            const AreaI area31;
+            const ZoomLevel zoom;
+            IQueryController* const controller;
+            const bool collectResult;
+
+            QVector<MapObjectsLoadingJob> jobs;
+            QAtomicInt nextJobIndex;
+
+            QMutex finishedJobsMutex;
+            QWaitCondition allJobsFinished;
+            int finishedJobsCount;
+
+            // Picks jobs one by one until none is left. Called both from pool threads and from
+            // calling thread, so that query never waits for a pool that is busy with something else
+            void processJobs()
+            {
+                for(;;)
+                {
+                    const auto jobIndex = nextJobIndex.fetchAndAddOrdered(1);
+                    if(jobIndex >= jobs.size())
+                        return;
+
+                    auto& job = jobs[jobIndex];
+                    if(!controller || !controller->isAborted())
+                    {
+                        OsmAnd::ObfMapSectionReader::loadMapObjects(job.reader, job.section, zoom, &area31,
+                            collectResult ? &job.result : nullptr, &job.foundation, nullptr, controller);
+                    }
+
+                    QMutexLocker scopedLock(&finishedJobsMutex);
+                    finishedJobsCount++;
+                    if(finishedJobsCount == jobs.size())
+                        allJobsFinished.wakeAll();
+                }
+            }
+        };
+
+    } // namespace ObfDataInterface_P_Internal
+} // namespace OsmAnd
+
+bool OsmAnd::ObfDataInterface_P::obtainSections(
+    const AreaI& area31, const ObfSectionsSpatialIndex::SectionType sectionType, const ZoomLevel* zoom,
+    QList<SectionEntry>& outSections, IQueryController* controller )
+{
+    if(!spatialIndex)
+    {
+        for(auto itObfReader = readers.begin(); itObfReader != readers.end(); ++itObfReader)
+        {
+            if(controller && controller->isAborted())
+                return false;
+
+            const auto& obfReader = *itObfReader;
+            const auto& obfInfo = obfReader->obtainInfo();
+            switch(sectionType)
+            {
+            case ObfSectionsSpatialIndex::MapSection:
+                for(auto itSection = obfInfo->mapSections.cbegin(); itSection != obfInfo->mapSections.cend(); ++itSection)
+                    outSections.push_back(SectionEntry(obfReader, *itSection));
+                break;
+            case ObfSectionsSpatialIndex::RoutingSection:
+                for(auto itSection = obfInfo->routingSections.cbegin(); itSection != obfInfo->routingSections.cend(); ++itSection)
+                    outSections.push_back(SectionEntry(obfReader, *itSection));
+                break;
+            case ObfSectionsSpatialIndex::PoiSection:
+                for(auto itSection = obfInfo->poiSections.cbegin(); itSection != obfInfo->poiSections.cend(); ++itSection)
+                    outSections.push_back(SectionEntry(obfReader, *itSection));
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    QList<const ObfSectionsSpatialIndex::Entry*> entries;
+    spatialIndex->query(area31, sectionType, zoom, entries);
+
+    // Keep same order as if all readers were iterated: by reader, and by section position in file
+    QList< std::pair< std::pair<int, uint32_t>, SectionEntry > > orderedSections;
+    for(auto itEntry = entries.cbegin(); itEntry != entries.cend(); ++itEntry)
+    {
+        const auto& entry = **itEntry;
+
+        const auto itReaderIdx = _readersIndices.constFind(entry.file.get());
+        if(itReaderIdx == _readersIndices.cend())
+            continue;
+
+        // Same section is listed once per each of it's map levels or routing root subsections
+        const auto sortKey = std::make_pair(*itReaderIdx, entry.section->offset);
+        auto itPosition = std::lower_bound(orderedSections.begin(), orderedSections.end(), sortKey,
+            [](const std::pair< std::pair<int, uint32_t>, SectionEntry >& l, const std::pair<int, uint32_t>& r) -> bool
+            {
+                return l.first < r;
+            });
+        if(itPosition != orderedSections.end() && itPosition->first == sortKey)
+            continue;
+        orderedSections.insert(itPosition, std::make_pair(sortKey, SectionEntry(readers[*itReaderIdx], entry.section)));
+    }
+
+    for(auto itSection = orderedSections.cbegin(); itSection != orderedSections.cend(); ++itSection)
+        outSections.push_back(itSection->second);
+
+    return true;
+}
+
+bool OsmAnd::ObfDataInterface_P::obtainMapSections(
+    const AreaI& area31, const ZoomLevel zoom, QList<MapSectionEntry>& outMapSections, IQueryController* controller )
+{
+    QList<SectionEntry> sections;
+    if(!obtainSections(area31, ObfSectionsSpatialIndex::MapSection, &zoom, sections, controller))
+        return false;
+
+    for(auto itSection = sections.cbegin(); itSection != sections.cend(); ++itSection)
+        outMapSections.push_back(MapSectionEntry(itSection->first, std::static_pointer_cast<const ObfMapSectionInfo>(itSection->second)));
+
+    return true;
+}
+
+void OsmAnd::ObfDataInterface_P::loadMapObjectsInParallel(
+    QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut, MapFoundationType* foundationOut,
+    const AreaI& area31, const ZoomLevel zoom, IQueryController* controller )
+{
+    using namespace ObfDataInterface_P_Internal;
+
+    // State is shared with pool tasks, that may outlive this call if they were not started before all jobs were done
+    const std::shared_ptr<MapObjectsLoadingState> state(new MapObjectsLoadingState(area31, zoom, controller, resultOut != nullptr));
+
+    // Collect (reader, map section) pairs to process
+    QList<MapSectionEntry> mapSections;
+    if(!obtainMapSections(area31, zoom, mapSections, controller))
+        return;
+    for(auto itMapSection = mapSections.cbegin(); itMapSection != mapSections.cend(); ++itMapSection)
+    {
+        MapObjectsLoadingJob job;
+        job.reader = itMapSection->first;
+        job.section = itMapSection->second;
+        state->jobs.push_back(job);
+    }
+    if(state->jobs.isEmpty())
+        return;
+
+    // Calling thread also processes jobs, so one less helper is needed
+    const auto& threadPool = Concurrent::pools->localStorage;
+    const auto helpersCount = qMin(state->jobs.size() - 1, threadPool->maxThreadCount());
+    for(auto helperIdx = 0; helperIdx < helpersCount; helperIdx++)
+    {
+        threadPool->start(new Concurrent::Task(
+            [state](const Concurrent::Task* task, QEventLoop& eventLoop)
+            {
+                state->processJobs();
+            }));
+    }
+    state->processJobs();
+
+    {
+        QMutexLocker scopedLock(&state->finishedJobsMutex);
+        while(state->finishedJobsCount != state->jobs.size())
+            state->allJobsFinished.wait(&state->finishedJobsMutex);
+    }
+
+    // Truncated query still gives whatever was read before it ran out of budget
+    if(controller && controller->isAborted() && !controller->isTruncated())
+        return;
+
+    // Merge results in same order as sequential loading would produce them
+    for(auto itJob = state->jobs.cbegin(); itJob != state->jobs.cend(); ++itJob)
+    {
+        const auto& job = *itJob;
+
+        if(resultOut)
+            resultOut->append(job.result);
+
+        if(foundationOut && job.foundation != MapFoundationType::Undefined)
+        {
+            if(*foundationOut == MapFoundationType::Undefined)
+                *foundationOut = job.foundation;
+            else if(*foundationOut != job.foundation)
+                *foundationOut = MapFoundationType::Mixed;
+        }
+    }
+}
@@ -27,22 +27,51 @@
 #include <array>
 
 #include <QList>
+#include <QHash>
 
 #include <OsmAndCore.h>
+#include <OsmAndCore/CommonTypes.h>
+#include <OsmAndCore/Map/MapTypes.h>
+
+#include "ObfSectionsSpatialIndex.h"
 
 namespace OsmAnd {
 
     class ObfReader;
+    class ObfFile;
+    class ObfSectionInfo;
+    class ObfMapSectionInfo;
+    namespace Model {
+        class MapObject;
+    } // namespace Model
+    class IQueryController;
 
     class ObfDataInterface;
     class ObfDataInterface_P
     {
     private:
     protected:
-        ObfDataInterface_P(ObfDataInterface* owner, const QList< std::shared_ptr<ObfReader> >& readers);
+        ObfDataInterface_P(ObfDataInterface* owner, const QList< std::shared_ptr<ObfReader> >& readers,
+            const std::shared_ptr<const ObfSectionsSpatialIndex>& spatialIndex);
 
         ObfDataInterface* const owner;
         const QList< std::shared_ptr<ObfReader> > readers;
+
+        // If available, only sections that intersect query area are visited
+        const std::shared_ptr<const ObfSectionsSpatialIndex> spatialIndex;
+        QHash< const ObfFile*, int > _readersIndices;
+
+        typedef std::pair< std::shared_ptr<ObfReader>, std::shared_ptr<const ObfSectionInfo> > SectionEntry;
+        bool obtainSections(const AreaI& area31, const ObfSectionsSpatialIndex::SectionType sectionType, const ZoomLevel* zoom,
+            QList<SectionEntry>& outSections, IQueryController* controller);
+
+        typedef std::pair< std::shared_ptr<ObfReader>, std::shared_ptr<const ObfMapSectionInfo> > MapSectionEntry;
+        bool obtainMapSections(const AreaI& area31, const ZoomLevel zoom, QList<MapSectionEntry>& outMapSections, IQueryController* controller);
+
+        volatile bool _parallelMapObjectsLoading;
+
+        void loadMapObjectsInParallel(QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut, MapFoundationType* foundationOut,
+            const AreaI& area31, const ZoomLevel zoom, IQueryController* controller);
     public:
         virtual ~ObfDataInterface_P();
 
@@ -1,4 +1,5 @@
 #include "ObfFile_P.h"
+#include "ObfFile.h"
 
 OsmAnd::ObfFile_P::ObfFile_P( ObfFile* owner_ )
     : owner(owner_)
@@ -8,3 +9,17 @@ OsmAnd::ObfFile_P::ObfFile_P( ObfFile* owner_ )
 OsmAnd::ObfFile_P::~ObfFile_P()
 {
 }
+
+std::shared_ptr<const OsmAnd::QMemoryMappedZeroCopyInputStream::Mapping> OsmAnd::ObfFile_P::obtainMapping()
+{
+    QMutexLocker scopedLock(&_mappingMutex);
+
+    // Mapping is created once, and shared by all readers of this file
+    if(!_mapping)
+    {
+        std::shared_ptr<QFile> file(new QFile(owner->fileInfo.absoluteFilePath()));
+        _mapping.reset(new QMemoryMappedZeroCopyInputStream::Mapping(file));
+    }
+
+    return _mapping;
+}
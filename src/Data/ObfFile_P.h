@@ -29,11 +29,14 @@
 #include <QMutex>
 
 #include <OsmAndCore.h>
+#include <QMemoryMappedZeroCopyInputStream.h>
 
 namespace OsmAnd {
 
     class ObfReader;
+    class ObfReader_P;
     class ObfInfo;
+    class ObfsCollection_P;
 
     class ObfFile;
     class OSMAND_CORE_API ObfFile_P
@@ -47,11 +50,17 @@ namespace OsmAnd {
 
         QMutex _obfInfoMutex;
         std::shared_ptr<ObfInfo> _obfInfo;
+
+        QMutex _mappingMutex;
+        std::shared_ptr<const QMemoryMappedZeroCopyInputStream::Mapping> _mapping;
+        std::shared_ptr<const QMemoryMappedZeroCopyInputStream::Mapping> obtainMapping();
     public:
         virtual ~ObfFile_P();
 
     friend class OsmAnd::ObfFile;
     friend class OsmAnd::ObfReader;
+    friend class OsmAnd::ObfReader_P;
+    friend class OsmAnd::ObfsCollection_P;
     };
 
 } // namespace OsmAnd
@@ -0,0 +1,149 @@
+#include "ObfMapSectionDataBlocksCache.h"
+
+#include "ObfMapSectionInfo.h"
+#include "MapObject.h"
+
+const std::shared_ptr<OsmAnd::ObfMapSectionDataBlocksCache> OsmAnd::ObfMapSectionDataBlocksCache::instance(new OsmAnd::ObfMapSectionDataBlocksCache());
+
+OsmAnd::ObfMapSectionDataBlocksCache::ObfMapSectionDataBlocksCache()
+    : _memoryLimit(32 * 1024 * 1024)
+    , _consumedMemory(0)
+    , _hits(0)
+    , _misses(0)
+    , _evictions(0)
+{
+}
+
+OsmAnd::ObfMapSectionDataBlocksCache::~ObfMapSectionDataBlocksCache()
+{
+}
+
+bool OsmAnd::ObfMapSectionDataBlocksCache::isEnabled() const
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    return (_memoryLimit > 0);
+}
+
+void OsmAnd::ObfMapSectionDataBlocksCache::setMemoryLimit( const size_t limitInBytes )
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    _memoryLimit = limitInBytes;
+    evictUntilFits(_memoryLimit);
+}
+
+size_t OsmAnd::ObfMapSectionDataBlocksCache::getMemoryLimit() const
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    return _memoryLimit;
+}
+
+std::shared_ptr<const OsmAnd::ObfMapSectionDataBlocksCache::Block> OsmAnd::ObfMapSectionDataBlocksCache::obtainBlock(
+    const std::shared_ptr<const ObfMapSectionInfo>& section, const uint32_t dataOffset,
+    const float geometrySimplificationTolerance )
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    const auto itEntry = _entries.find(Key(section.get(), dataOffset));
+    if(itEntry == _entries.end())
+    {
+        _misses++;
+        return nullptr;
+    }
+
+    // Block decoded with other tolerance is stale, so it's dropped to let fresh one take it's place
+    if(itEntry->block->geometrySimplificationTolerance != geometrySimplificationTolerance)
+    {
+        removeEntry(itEntry);
+        _misses++;
+        return nullptr;
+    }
+    _hits++;
+
+    // Mark as most recently used
+    auto& entry = *itEntry;
+    _lru.splice(_lru.begin(), _lru, entry.lruPosition);
+
+    return entry.block;
+}
+
+void OsmAnd::ObfMapSectionDataBlocksCache::putBlock(
+    const std::shared_ptr<const ObfMapSectionInfo>& section, const uint32_t dataOffset, const std::shared_ptr<const Block>& block )
+{
+    size_t blockConsumedMemory = sizeof(Block);
+    for(auto itMapObject = block->mapObjects.cbegin(); itMapObject != block->mapObjects.cend(); ++itMapObject)
+        blockConsumedMemory += (*itMapObject)->calculateApproxConsumedMemory();
+
+    QMutexLocker scopedLock(&_mutex);
+
+    if(blockConsumedMemory > _memoryLimit)
+        return;
+
+    // Same block may have been decoded simultaneously by other query. If that one was decoded
+    // with other tolerance, it's replaced, since one of them is stale anyways
+    const Key key(section.get(), dataOffset);
+    const auto itExistingEntry = _entries.find(key);
+    if(itExistingEntry != _entries.end())
+    {
+        if(itExistingEntry->block->geometrySimplificationTolerance == block->geometrySimplificationTolerance)
+            return;
+        removeEntry(itExistingEntry);
+    }
+
+    evictUntilFits(_memoryLimit - blockConsumedMemory);
+
+    _lru.push_front(key);
+    Entry entry;
+    entry.block = block;
+    entry.consumedMemory = blockConsumedMemory;
+    entry.lruPosition = _lru.begin();
+    _entries.insert(key, entry);
+    _consumedMemory += blockConsumedMemory;
+}
+
+void OsmAnd::ObfMapSectionDataBlocksCache::evictUntilFits( size_t memoryLimit )
+{
+    while(_consumedMemory > memoryLimit && !_lru.empty())
+    {
+        removeEntry(_entries.find(_lru.back()));
+        _evictions++;
+    }
+}
+
+void OsmAnd::ObfMapSectionDataBlocksCache::removeEntry( const QHash<Key, Entry>::iterator& itEntry )
+{
+    _consumedMemory -= itEntry->consumedMemory;
+    _lru.erase(itEntry->lruPosition);
+    _entries.erase(itEntry);
+}
+
+OsmAnd::ObfMapSectionReader::DataBlocksCacheMetrics OsmAnd::ObfMapSectionDataBlocksCache::getMetrics() const
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    ObfMapSectionReader::DataBlocksCacheMetrics metrics;
+    metrics.hits = _hits;
+    metrics.misses = _misses;
+    metrics.evictions = _evictions;
+    metrics.blocksCount = _entries.size();
+    metrics.consumedMemory = _consumedMemory;
+    metrics.memoryLimit = _memoryLimit;
+    return metrics;
+}
+
+void OsmAnd::ObfMapSectionDataBlocksCache::clear()
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    _entries.clear();
+    _lru.clear();
+    _consumedMemory = 0;
+}
+
+OsmAnd::ObfMapSectionDataBlocksCache::Block::Block( const std::shared_ptr<const ObfMapSectionInfo>& section_, const float geometrySimplificationTolerance_ )
+    : section(section_)
+    , geometrySimplificationTolerance(geometrySimplificationTolerance_)
+{
+}
@@ -0,0 +1,106 @@
+/**
+* @file
+*
+* @section LICENSE
+*
+* OsmAnd - Android navigation software based on OSM maps.
+* Copyright (C) 2010-2013  OsmAnd Authors listed in AUTHORS file
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __OBF_MAP_SECTION_DATA_BLOCKS_CACHE_H_
+#define __OBF_MAP_SECTION_DATA_BLOCKS_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <list>
+
+#include <QList>
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+
+#include <OsmAndCore.h>
+#include <ObfMapSectionReader.h>
+
+namespace OsmAnd {
+
+    class ObfMapSectionInfo;
+    namespace Model {
+        class MapObject;
+    } // namespace Model
+
+    // Process-wide LRU cache of decoded map data blocks, limited by approximate consumed memory
+    class ObfMapSectionDataBlocksCache
+    {
+        Q_DISABLE_COPY(ObfMapSectionDataBlocksCache)
+    public:
+        struct Block
+        {
+            Block(const std::shared_ptr<const ObfMapSectionInfo>& section, const float geometrySimplificationTolerance);
+
+            // Holds section, so it's address can not be reused while block is cached
+            const std::shared_ptr<const ObfMapSectionInfo> section;
+
+            // Tolerance geometry was simplified with. Query that started before tolerance was changed
+            // may still put its block after cache was cleared, so such blocks are never handed out
+            const float geometrySimplificationTolerance;
+
+            // All map objects of block, regardless of query bbox
+            QList< std::shared_ptr<const OsmAnd::Model::MapObject> > mapObjects;
+        };
+    private:
+        typedef QPair<const ObfMapSectionInfo*, uint32_t> Key;
+        struct Entry
+        {
+            std::shared_ptr<const Block> block;
+            size_t consumedMemory;
+            std::list<Key>::iterator lruPosition;
+        };
+
+        mutable QMutex _mutex;
+        size_t _memoryLimit;
+        size_t _consumedMemory;
+        QHash<Key, Entry> _entries;
+        std::list<Key> _lru;
+
+        uint64_t _hits;
+        uint64_t _misses;
+        uint64_t _evictions;
+
+        void evictUntilFits(size_t memoryLimit);
+        void removeEntry(const QHash<Key, Entry>::iterator& itEntry);
+    protected:
+        ObfMapSectionDataBlocksCache();
+    public:
+        virtual ~ObfMapSectionDataBlocksCache();
+
+        static const std::shared_ptr<ObfMapSectionDataBlocksCache> instance;
+
+        bool isEnabled() const;
+        void setMemoryLimit(const size_t limitInBytes);
+        size_t getMemoryLimit() const;
+
+        std::shared_ptr<const Block> obtainBlock(const std::shared_ptr<const ObfMapSectionInfo>& section, const uint32_t dataOffset,
+            const float geometrySimplificationTolerance);
+        void putBlock(const std::shared_ptr<const ObfMapSectionInfo>& section, const uint32_t dataOffset, const std::shared_ptr<const Block>& block);
+
+        ObfMapSectionReader::DataBlocksCacheMetrics getMetrics() const;
+        void clear();
+    };
+
+} // namespace OsmAnd
+
+#endif // __OBF_MAP_SECTION_DATA_BLOCKS_CACHE_H_
@@ -18,8 +18,6 @@ OsmAnd::ObfMapSectionInfo_P::Rules::Rules()
     , _onewayAttribute(-1)
     , _onewayReverseAttribute(-1)
 {
-    _positiveLayers.reserve(2);
-    _negativeLayers.reserve(2);
 }
 
 OsmAnd::ObfMapSectionLevel_P::ObfMapSectionLevel_P( ObfMapSectionLevel* owner_ )
@@ -31,6 +29,11 @@ OsmAnd::ObfMapSectionLevel_P::~ObfMapSectionLevel_P()
 {
 }
 
+OsmAnd::ObfMapSectionLevel_P::TreeIndex::TreeIndex()
+    : rootsCount(0)
+{
+}
+
 OsmAnd::ObfMapSectionLevelTreeNode::ObfMapSectionLevelTreeNode()
     : _childrenInnerOffset(0)
     , _dataOffset(0)
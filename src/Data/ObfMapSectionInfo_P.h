@@ -25,17 +25,18 @@
 
 #include <cstdint>
 #include <memory>
-#include <tuple>
 
 #include <QMutex>
 #include <QSet>
 #include <QHash>
 #include <QMap>
+#include <QVector>
 #include <QString>
 
 #include <OsmAndCore.h>
 #include <CommonTypes.h>
 #include <MapTypes.h>
+#include <MapObject.h>
 
 namespace OsmAnd {
 
@@ -68,12 +69,25 @@ namespace OsmAnd {
 
         ObfMapSectionLevel* const owner;
 
-        QMutex _rootNodesMutex;
-        struct RootNodes
+        QMutex _treeIndexMutex;
+        struct TreeIndex
         {
-            QList< std::shared_ptr<ObfMapSectionLevelTreeNode> > nodes;
+            // Children of each node are stored contiguously, root nodes are [0, rootsCount)
+            struct Node
+            {
+                AreaI area31;
+                uint32_t dataOffset;
+                MapFoundationType foundation;
+                uint32_t firstChild;
+                uint32_t childrenCount;
+            };
+
+            TreeIndex();
+
+            QVector<Node> nodes;
+            uint32_t rootsCount;
         };
-        std::shared_ptr<RootNodes> _rootNodes;
+        std::shared_ptr<const TreeIndex> _treeIndex;
     public:
         virtual ~ObfMapSectionLevel_P();
 
@@ -91,14 +105,11 @@ namespace OsmAnd {
         ObfMapSectionInfo* const owner;
 
         QMutex _rulesMutex;
-        struct Rules
+        // Rule ids of map objects are resolved via tables of base class, that map objects share
+        struct Rules : public Model::MapObject::EncodingDecodingRules
         {
-            typedef std::tuple<QString, QString, uint32_t> DecodingRule;
-
             Rules();
 
-            QHash< QString, QHash<QString, uint32_t> > _encodingRules;
-            QMap< uint32_t, DecodingRule > _decodingRules;
             uint32_t _nameEncodingType;
             uint32_t _refEncodingType;
             uint32_t _coastlineEncodingType;
@@ -106,8 +117,6 @@ namespace OsmAnd {
             uint32_t _landEncodingType;
             uint32_t _onewayAttribute;
             uint32_t _onewayReverseAttribute;
-            QSet<uint32_t> _positiveLayers;
-            QSet<uint32_t> _negativeLayers;
         };
         std::shared_ptr<Rules> _rules;
     public:
@@ -2,6 +2,8 @@
 #include "ObfMapSectionReader_P.h"
 
 #include "ObfReader.h"
+#include "ObfReader_P.h"
+#include "ObfMapSectionDataBlocksCache.h"
 
 OsmAnd::ObfMapSectionReader::ObfMapSectionReader()
 {
@@ -17,5 +19,66 @@ void OsmAnd::ObfMapSectionReader::loadMapObjects(
     QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut /*= nullptr*/, MapFoundationType* foundationOut /*= nullptr*/,
     std::function<bool (const std::shared_ptr<const OsmAnd::Model::MapObject>&)> visitor /*= nullptr*/, IQueryController* controller /*= nullptr*/ )
 {
-    ObfMapSectionReader_P::loadMapObjects(reader->_d, section, zoom, bbox31, resultOut, foundationOut, visitor, controller);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfMapSectionReader_P::loadMapObjects(cursor.reader(), section, zoom, bbox31, resultOut, foundationOut, visitor, controller);
+}
+
+void OsmAnd::ObfMapSectionReader::loadMapObjectsForAreas(
+    const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+    ZoomLevel zoom, const QVector<AreaI>& areas31,
+    QVector< QList< std::shared_ptr<const OsmAnd::Model::MapObject> > >* resultsOut /*= nullptr*/, QVector<MapFoundationType>* foundationsOut /*= nullptr*/,
+    IQueryController* controller /*= nullptr*/ )
+{
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfMapSectionReader_P::loadMapObjectsForAreas(cursor.reader(), section, zoom, areas31, resultsOut, foundationsOut, nullptr, controller);
+}
+
+void OsmAnd::ObfMapSectionReader::scanMapObjects(
+    const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+    ZoomLevel zoom, const AreaI* bbox31,
+    std::function<bool (const MapObjectView&)> visitor,
+    QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* promotedOut /*= nullptr*/, MapFoundationType* foundationOut /*= nullptr*/,
+    IQueryController* controller /*= nullptr*/ )
+{
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfMapSectionReader_P::scanMapObjects(cursor.reader(), section, zoom, bbox31, visitor, promotedOut, foundationOut, controller);
+}
+
+bool OsmAnd::ObfMapSectionReader::decodeRule( const std::shared_ptr<const ObfMapSectionInfo>& section, uint32_t ruleId, TagValue& outTagValue )
+{
+    return ObfMapSectionReader_P::decodeRule(section, ruleId, outTagValue);
+}
+
+void OsmAnd::ObfMapSectionReader::setGeometrySimplificationTolerance( const float tolerance )
+{
+    if(!ObfMapSectionReader_P::setGeometrySimplificationTolerance(tolerance))
+        return;
+
+    // Cached blocks were decoded using previous tolerance
+    ObfMapSectionDataBlocksCache::instance->clear();
+}
+
+float OsmAnd::ObfMapSectionReader::getGeometrySimplificationTolerance()
+{
+    return ObfMapSectionReader_P::getGeometrySimplificationTolerance();
+}
+
+void OsmAnd::ObfMapSectionReader::setDataBlocksCacheMemoryLimit( const size_t limitInBytes )
+{
+    ObfMapSectionDataBlocksCache::instance->setMemoryLimit(limitInBytes);
+}
+
+size_t OsmAnd::ObfMapSectionReader::getDataBlocksCacheMemoryLimit()
+{
+    return ObfMapSectionDataBlocksCache::instance->getMemoryLimit();
+}
+
+OsmAnd::ObfMapSectionReader::DataBlocksCacheMetrics OsmAnd::ObfMapSectionReader::getDataBlocksCacheMetrics()
+{
+    return ObfMapSectionDataBlocksCache::instance->getMetrics();
+}
+
+void OsmAnd::ObfMapSectionReader::clearDataBlocksCache()
+{
+    ObfMapSectionDataBlocksCache::instance->clear();
 }
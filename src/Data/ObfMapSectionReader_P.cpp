@@ -1,12 +1,17 @@
 #include "ObfMapSectionReader_P.h"
 
 #include <cinttypes>
+#include <cmath>
+#include <algorithm>
+#include <limits>
 
 #include "ObfReader.h"
 #include "ObfReader_P.h"
 #include "ObfMapSectionInfo.h"
 #include "ObfMapSectionInfo_P.h"
 #include "ObfReaderUtilities.h"
+#include "ObfStringTable.h"
+#include "ObfMapSectionDataBlocksCache.h"
 #include "MapObject.h"
 #include "Logging.h"
 #include "Utilities.h"
@@ -14,6 +19,28 @@
 #include "OBF.pb.h"
 #include <google/protobuf/wire_format_lite.h>
 
+namespace OsmAnd {
+    namespace ObfMapSectionReader_P_Internal {
+
+        // Query without bbox covers entire 31-bit space
+        inline AreaI areaOrEverything(const AreaI* bbox31)
+        {
+            if(bbox31)
+                return *bbox31;
+
+            AreaI area31;
+            area31.top = area31.left = 0;
+            area31.bottom = area31.right = std::numeric_limits<int32_t>::max();
+            return area31;
+        }
+
+    } // namespace ObfMapSectionReader_P_Internal
+} // namespace OsmAnd
+using namespace OsmAnd::ObfMapSectionReader_P_Internal;
+
+QMutex OsmAnd::ObfMapSectionReader_P::_geometrySimplificationToleranceMutex;
+float OsmAnd::ObfMapSectionReader_P::_geometrySimplificationTolerance = 0.0f;
+
 OsmAnd::ObfMapSectionReader_P::ObfMapSectionReader_P()
 {
 }
@@ -125,7 +152,7 @@ void OsmAnd::ObfMapSectionReader_P::readRules(
         {
         case 0:
             {
-                auto free = rules->_decodingRules.size() * 2 + 1;
+                auto free = rules->decodingRulesCount * 2 + 1;
                 rules->_coastlineBrokenEncodingType = free++;
                 createRule(rules, 0, rules->_coastlineBrokenEncodingType, QString::fromLatin1("natural"), QString::fromLatin1("coastline_broken"));
                 if(rules->_landEncodingType == -1)
@@ -190,13 +217,7 @@ void OsmAnd::ObfMapSectionReader_P::readRule(
 
 void OsmAnd::ObfMapSectionReader_P::createRule( const std::shared_ptr<ObfMapSectionInfo_P::Rules>& rules, uint32_t ruleType, uint32_t ruleId, const QString& ruleTag, const QString& ruleVal )
 {
-    auto itEncodingRule = rules->_encodingRules.find(ruleTag);
-    if(itEncodingRule == rules->_encodingRules.end())
-        itEncodingRule = rules->_encodingRules.insert(ruleTag, QHash<QString, uint32_t>());
-    itEncodingRule->insert(ruleVal, ruleId);
-    
-    if(!rules->_decodingRules.contains(ruleId))
-        rules->_decodingRules.insert(ruleId, ObfMapSectionInfo_P::Rules::DecodingRule(ruleTag, ruleVal, ruleType));
+    rules->addRule(ruleId, ruleTag, ruleVal);
 
     if(QLatin1String("name") == ruleTag)
         rules->_nameEncodingType = ruleId;
@@ -210,33 +231,23 @@ void OsmAnd::ObfMapSectionReader_P::createRule( const std::shared_ptr<ObfMapSect
         rules->_onewayReverseAttribute = ruleId;
     else if(QLatin1String("ref") == ruleTag)
         rules->_refEncodingType = ruleId;
-    else if(QLatin1String("tunnel") == ruleTag)
-        rules->_negativeLayers.insert(ruleId);
-    else if(QLatin1String("bridge") == ruleTag)
-        rules->_positiveLayers.insert(ruleId);
-    else if(QLatin1String("layer") == ruleTag)
-    {
-        if(!ruleVal.isEmpty() && ruleVal != QLatin1String("0"))
-        {
-            if (ruleVal[0] == '-')
-                rules->_negativeLayers.insert(ruleId);
-            else
-                rules->_positiveLayers.insert(ruleId);
-        }
-    }
 }
 
 void OsmAnd::ObfMapSectionReader_P::readMapLevelTreeNodes(
     const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
-    const std::shared_ptr<const ObfMapSectionLevel>& level, QList< std::shared_ptr<ObfMapSectionLevelTreeNode> >& trees )
+    const std::shared_ptr<const ObfMapSectionLevel>& level, ObfMapSectionLevel_P::TreeIndex& treeIndex )
 {
     auto cis = reader->_codedInputStream.get();
+
+    QList< std::shared_ptr<ObfMapSectionLevelTreeNode> > rootNodes;
     for(;;)
     {
         gpb::uint32 tag = cis->ReadTag();
         switch(gpb::internal::WireFormatLite::GetTagFieldNumber(tag))
         {
         case 0:
+            treeIndex.rootsCount = rootNodes.size();
+            appendTreeNodesToIndex(reader, section, rootNodes, treeIndex);
             return;
         case OBF::OsmAndMapIndex_MapRootLevel::kBoxesFieldNumber:
             {
@@ -250,11 +261,13 @@ void OsmAnd::ObfMapSectionReader_P::readMapLevelTreeNodes(
                 readTreeNode(reader, section, level->area31, levelTree);
                 
                 cis->PopLimit(oldLimit);
-                trees.push_back(levelTree);
+                rootNodes.push_back(levelTree);
             }
             break;
         case OBF::OsmAndMapIndex_MapRootLevel::kBlocksFieldNumber:
             cis->Skip(cis->BytesUntilLimit());
+            treeIndex.rootsCount = rootNodes.size();
+            appendTreeNodesToIndex(reader, section, rootNodes, treeIndex);
             return;
         default:
             ObfReaderUtilities::skipUnknownField(cis, tag);
@@ -330,20 +343,23 @@ void OsmAnd::ObfMapSectionReader_P::readTreeNode(
 void OsmAnd::ObfMapSectionReader_P::readTreeNodeChildren(
     const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
     const std::shared_ptr<ObfMapSectionLevelTreeNode>& treeNode,
-    MapFoundationType& foundation,
-    QList< std::shared_ptr<ObfMapSectionLevelTreeNode> >* nodesWithData,
-    const AreaI* bbox31,
-    IQueryController* controller)
+    ObfMapSectionLevel_P::TreeIndex& treeIndex, const uint32_t treeNodeIndex)
 {
     auto cis = reader->_codedInputStream.get();
-    foundation = MapFoundationType::Undefined;
 
+    QList< std::shared_ptr<ObfMapSectionLevelTreeNode> > childNodes;
     for(;;)
     {
         auto tag = cis->ReadTag();
         switch(gpb::internal::WireFormatLite::GetTagFieldNumber(tag))
         {
         case 0:
+            {
+                auto& indexNode = treeIndex.nodes[treeNodeIndex];
+                indexNode.firstChild = treeIndex.nodes.size();
+                indexNode.childrenCount = childNodes.size();
+                appendTreeNodesToIndex(reader, section, childNodes, treeIndex);
+            }
             return;
         case OBF::OsmAndMapIndex_MapDataBox::kBoxesFieldNumber:
             {
@@ -355,43 +371,9 @@ void OsmAnd::ObfMapSectionReader_P::readTreeNodeChildren(
                 childNode->_offset = offset;
                 childNode->_length = length;
                 readTreeNode(reader, section, treeNode->_area31, childNode);
-                if(bbox31)
-                {
-                    const auto shouldSkip =
-                        !bbox31->contains(childNode->_area31) &&
-                        !childNode->_area31.contains(*bbox31) &&
-                        !bbox31->intersects(childNode->_area31);
-                    if(shouldSkip)
-                    {
-                        cis->Skip(cis->BytesUntilLimit());
-                        cis->PopLimit(oldLimit);
-                        break;
-                    }
-                }
                 cis->PopLimit(oldLimit);
 
-                if(nodesWithData && childNode->_dataOffset > 0)
-                    nodesWithData->push_back(childNode);
-
-                auto childrenFoundation = MapFoundationType::Undefined;
-                if(childNode->_childrenInnerOffset > 0)
-                {
-                    cis->Seek(offset);
-                    oldLimit = cis->PushLimit(length);
-                    cis->Skip(childNode->_childrenInnerOffset);
-                    readTreeNodeChildren(reader, section, childNode, childrenFoundation, nodesWithData, bbox31, controller);
-                    assert(cis->BytesUntilLimit() == 0);
-                    cis->PopLimit(oldLimit);
-                }
-
-                const auto foundationToMerge = (childrenFoundation != MapFoundationType::Undefined) ? childrenFoundation : childNode->_foundation;
-                if(foundationToMerge != MapFoundationType::Undefined)
-                {
-                    if(foundation == MapFoundationType::Undefined)
-                        foundation = foundationToMerge;
-                    else if(foundation != foundationToMerge)
-                        foundation = MapFoundationType::Mixed;
-                }
+                childNodes.push_back(childNode);
             }
             break;
         default:
@@ -401,23 +383,69 @@ void OsmAnd::ObfMapSectionReader_P::readTreeNodeChildren(
     }
 }
 
-void OsmAnd::ObfMapSectionReader_P::readMapObjectsBlock(
+void OsmAnd::ObfMapSectionReader_P::appendTreeNodesToIndex(
+    const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+    const QList< std::shared_ptr<ObfMapSectionLevelTreeNode> >& treeNodes,
+    ObfMapSectionLevel_P::TreeIndex& treeIndex)
+{
+    auto cis = reader->_codedInputStream.get();
+
+    // First put all siblings, so that they occupy continuous range
+    const uint32_t firstNodeIndex = treeIndex.nodes.size();
+    for(auto itTreeNode = treeNodes.cbegin(); itTreeNode != treeNodes.cend(); ++itTreeNode)
+    {
+        const auto& treeNode = *itTreeNode;
+
+        ObfMapSectionLevel_P::TreeIndex::Node indexNode;
+        indexNode.area31 = treeNode->_area31;
+        indexNode.dataOffset = treeNode->_dataOffset;
+        indexNode.foundation = treeNode->_foundation;
+        indexNode.firstChild = 0;
+        indexNode.childrenCount = 0;
+        treeIndex.nodes.push_back(indexNode);
+    }
+
+    // And only then go deeper
+    for(auto treeNodeIdx = 0; treeNodeIdx < treeNodes.size(); treeNodeIdx++)
+    {
+        const auto& treeNode = treeNodes[treeNodeIdx];
+        if(treeNode->_childrenInnerOffset == 0)
+            continue;
+
+        cis->Seek(treeNode->_offset);
+        auto oldLimit = cis->PushLimit(treeNode->_length);
+        cis->Skip(treeNode->_childrenInnerOffset);
+        readTreeNodeChildren(reader, section, treeNode, treeIndex, firstNodeIndex + treeNodeIdx);
+        // Children that have own children were read by seeking into them, so stream is left at the end
+        // of last such child rather than at the end of this node
+        cis->Skip(cis->BytesUntilLimit());
+        cis->PopLimit(oldLimit);
+    }
+}
+
+unsigned int OsmAnd::ObfMapSectionReader_P::readMapObjectsBlock(
     const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
-    const std::shared_ptr<ObfMapSectionLevelTreeNode>& tree,
+    const ObfMapSectionLevel_P::TreeIndex::Node& treeNode,
     QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut,
     const AreaI* bbox31,
+    DecodingBuffers& scratch,
     std::function<bool (const std::shared_ptr<const OsmAnd::Model::MapObject>&)> visitor,
     IQueryController* controller)
 {
     auto cis = reader->_codedInputStream.get();
 
     QList< std::shared_ptr<OsmAnd::Model::MapObject> > intermediateResult;
-    QStringList mapObjectsNamesTable;
+    const std::shared_ptr<ObfStringTable> mapObjectsNamesTable(new ObfStringTable());
     gpb::uint64 baseId = 0;
+    unsigned int acceptedCount = 0;
     for(;;)
     {
+        // Rest of block is skipped, so caller still finds stream at the end of block's limit
         if(controller && controller->isAborted())
-            return;
+        {
+            cis->Skip(cis->BytesUntilLimit());
+            return acceptedCount;
+        }
         
         auto tag = cis->ReadTag();
         switch(gpb::internal::WireFormatLite::GetTagFieldNumber(tag))
@@ -427,32 +455,19 @@ void OsmAnd::ObfMapSectionReader_P::readMapObjectsBlock(
             {
                 const auto& entry = *itEntry;
 
-                // Fill names of roads from stringtable
-                for(auto itNameEntry = entry->_names.begin(); itNameEntry != entry->_names.end(); ++itNameEntry)
-                {
-                    const auto& encodedId = itNameEntry.value();
-                    uint32_t stringId = ObfReaderUtilities::decodeIntegerFromString(encodedId);
-
-                    if(stringId >= mapObjectsNamesTable.size())
-                    {
-                        LogPrintf(LogSeverityLevel::Error,
-                            "Data mismatch: string #%d (map object #%" PRIu64 " (%" PRIi64 ") not found in string table (size %d) in section '%s'",
-                            stringId,
-                            entry->id >> 1, static_cast<int64_t>(entry->id) / 2,
-                            mapObjectsNamesTable.size(), qPrintable(section->name));
-                        itNameEntry.value() = QString::fromLatin1("#%1 NOT FOUND").arg(stringId);
-                        continue;
-                    }
-                    itNameEntry.value() = mapObjectsNamesTable[stringId];
-                }
+                // Names are decoded from stringtable only on request
+                attachMapObjectNames(section, mapObjectsNamesTable, entry);
 
                 if(!visitor || visitor(entry))
                 {
                     if(resultOut)
                         resultOut->push_back(entry);
+                    acceptedCount++;
                 }
+                else
+                    scratch.statistics.objectsDiscarded++;
             }
-            return;
+            return acceptedCount;
         case OBF::MapDataBlock::kBaseIdFieldNumber:
             cis->ReadVarint64(&baseId);
             break;
@@ -462,13 +477,13 @@ void OsmAnd::ObfMapSectionReader_P::readMapObjectsBlock(
                 cis->ReadVarint32(&length);
                 auto oldLimit = cis->PushLimit(length);
                 auto pos = cis->CurrentPosition();
-                std::shared_ptr<OsmAnd::Model::MapObject> mapObject;
-                readMapObject(reader, section, tree, baseId, mapObject, bbox31);
-                if(mapObject)
+                if(readMapObjectView(reader, section, treeNode, baseId, scratch, bbox31))
                 {
-                    mapObject->_foundation = tree->_foundation;
-                    intermediateResult.push_back(mapObject);
+                    intermediateResult.push_back(promoteMapObjectView(section, scratch.view));
+                    scratch.statistics.objectsDecoded++;
                 }
+                else
+                    scratch.statistics.objectsDiscarded++;
                 assert(cis->BytesUntilLimit() == 0);
                 cis->PopLimit(oldLimit);
             }
@@ -484,7 +499,9 @@ void OsmAnd::ObfMapSectionReader_P::readMapObjectsBlock(
                     cis->PopLimit(oldLimit);
                     break;
                 }
-                ObfReaderUtilities::readStringTable(cis, mapObjectsNamesTable);
+                const QueryStatistics::Stopwatch stringTableStopwatch(scratch.collectStatistics);
+                mapObjectsNamesTable->read(cis);
+                scratch.statistics.stringTablesReadingTime += stringTableStopwatch.elapsed();
                 assert(cis->BytesUntilLimit() == 0);
                 cis->PopLimit(oldLimit);
             }
@@ -496,15 +513,579 @@ void OsmAnd::ObfMapSectionReader_P::readMapObjectsBlock(
     }
 }
 
-void OsmAnd::ObfMapSectionReader_P::readMapObject(
+void OsmAnd::ObfMapSectionReader_P::attachMapObjectNames(
+    const std::shared_ptr<const ObfMapSectionInfo>& section, const std::shared_ptr<const ObfStringTable>& namesTable,
+    const std::shared_ptr<OsmAnd::Model::MapObject>& mapObject)
+{
+    if(mapObject->_namesIds.isEmpty())
+        return;
+
+    // Empty names carry nothing to render, so drop them to keep hasNames() meaningful
+    auto& namesIds = mapObject->_namesIds;
+    for(auto itNameId = namesIds.begin(); itNameId != namesIds.end();)
+    {
+        if(namesTable->isEmptyString(itNameId->second))
+            itNameId = namesIds.erase(itNameId);
+        else
+            ++itNameId;
+    }
+    if(namesIds.isEmpty())
+        return;
+    mapObject->_stringTable = namesTable;
+
+    for(auto itNameId = namesIds.cbegin(); itNameId != namesIds.cend(); ++itNameId)
+    {
+        const auto stringId = itNameId->second;
+        if(namesTable->contains(stringId))
+            continue;
+
+        LogPrintf(LogSeverityLevel::Error,
+            "Data mismatch: string #%d (map object #%" PRIu64 " (%" PRIi64 ") not found in string table (size %d) in section '%s'",
+            stringId,
+            mapObject->id >> 1, static_cast<int64_t>(mapObject->id) / 2,
+            namesTable->size(), qPrintable(section->name));
+    }
+}
+
+void OsmAnd::ObfMapSectionReader_P::obtainRules(
+    const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section)
+{
+    auto cis = reader->_codedInputStream.get();
+
+    QMutexLocker scopedLock(&section->_d->_rulesMutex);
+
+    if(!section->_d->_rules)
+    {
+        cis->Seek(section->_offset);
+        auto oldLimit = cis->PushLimit(section->_length);
+        section->_d->_rules.reset(new ObfMapSectionInfo_P::Rules());
+        readRules(reader, section->_d->_rules);
+        cis->PopLimit(oldLimit);
+    }
+}
+
+std::shared_ptr<const OsmAnd::ObfMapSectionLevel_P::TreeIndex> OsmAnd::ObfMapSectionReader_P::obtainTreeIndex(
     const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
-    const std::shared_ptr<ObfMapSectionLevelTreeNode>& treeNode,
+    const std::shared_ptr<const ObfMapSectionLevel>& mapLevel)
+{
+    auto cis = reader->_codedInputStream.get();
+
+    QMutexLocker scopedLock(&mapLevel->_d->_treeIndexMutex);
+
+    // If tree index of map level was not yet built, do it now
+    if(!mapLevel->_d->_treeIndex)
+    {
+        cis->Seek(mapLevel->_offset);
+        auto oldLimit = cis->PushLimit(mapLevel->_length);
+        cis->Skip(mapLevel->_boxesInnerOffset);
+        std::shared_ptr<ObfMapSectionLevel_P::TreeIndex> newTreeIndex(new ObfMapSectionLevel_P::TreeIndex());
+        readMapLevelTreeNodes(reader, section, mapLevel, *newTreeIndex);
+        newTreeIndex->nodes.squeeze();
+        mapLevel->_d->_treeIndex = newTreeIndex;
+        cis->PopLimit(oldLimit);
+    }
+
+    return mapLevel->_d->_treeIndex;
+}
+
+void OsmAnd::ObfMapSectionReader_P::queryTreeNodes(
+    const ObfMapSectionLevel_P::TreeIndex& treeIndex, const AreaI* bbox31,
+    QList< const ObfMapSectionLevel_P::TreeIndex::Node* >& nodesWithData,
+    MapFoundationType& foundation,
+    unsigned int* visitedNodesCount /*= nullptr*/)
+{
+    const auto area31 = areaOrEverything(bbox31);
+
+    QVector<MapFoundationType> foundations(1, foundation);
+    queryTreeNodesForAreas(treeIndex, QVector<AreaI>(1, area31), foundations, nodesWithData, visitedNodesCount);
+    foundation = foundations.first();
+}
+
+void OsmAnd::ObfMapSectionReader_P::queryTreeNodesForAreas(
+    const ObfMapSectionLevel_P::TreeIndex& treeIndex, const QVector<AreaI>& areas31,
+    QVector<MapFoundationType>& foundations,
+    QList< const ObfMapSectionLevel_P::TreeIndex::Node* >& nodesWithData,
+    unsigned int* visitedNodesCount /*= nullptr*/)
+{
+    const auto areasCount = areas31.size();
+    if(areasCount == 0)
+        return;
+
+    // Top slice holds all areas, and foundations given by caller
+    TreeNodesQuery query(treeIndex, areas31, nodesWithData);
+    query.areasIndices.resize(areasCount);
+    for(auto areaIdx = 0; areaIdx < areasCount; areaIdx++)
+        query.areasIndices[areaIdx] = areaIdx;
+    query.foundations = foundations;
+
+    queryTreeNodesLevel(query, 0, treeIndex.rootsCount, 0, areasCount);
+
+    for(auto areaIdx = 0; areaIdx < areasCount; areaIdx++)
+        foundations[areaIdx] = query.foundations[areaIdx];
+    if(visitedNodesCount)
+        (*visitedNodesCount) += query.visitedNodesCount;
+
+    // Read data blocks in file order
+    qSort(nodesWithData.begin(), nodesWithData.end(), [](const ObfMapSectionLevel_P::TreeIndex::Node* l, const ObfMapSectionLevel_P::TreeIndex::Node* r) -> bool
+    {
+        return l->dataOffset < r->dataOffset;
+    });
+}
+
+void OsmAnd::ObfMapSectionReader_P::queryTreeNodesLevel(
+    TreeNodesQuery& query,
+    const uint32_t firstNodeIdx, const uint32_t nodesCount,
+    const int depth, const int parentAreasCount)
+{
+    const auto areasCount = query.areas31.size();
+    const auto parentSlice = depth * areasCount;
+    const auto nodeSlice = parentSlice + areasCount;
+    if(query.areasIndices.size() < nodeSlice + areasCount)
+    {
+        query.areasIndices.resize(nodeSlice + areasCount);
+        query.foundations.resize(nodeSlice + areasCount);
+    }
+
+    const auto nodesEnd = firstNodeIdx + nodesCount;
+    for(auto nodeIdx = firstNodeIdx; nodeIdx < nodesEnd; nodeIdx++)
+    {
+        const auto& node = query.treeIndex.nodes[nodeIdx];
+
+        // Only areas that intersect parent node are checked against it's children. Foundations
+        // reported by children are reset in place, and only for these areas
+        auto nodeAreasCount = 0;
+        for(auto idx = 0; idx < parentAreasCount; idx++)
+        {
+            const auto areaIndex = query.areasIndices[parentSlice + idx];
+            const auto& area31 = query.areas31[areaIndex];
+            const auto intersects =
+                area31.contains(node.area31) ||
+                node.area31.contains(area31) ||
+                area31.intersects(node.area31);
+            if(!intersects)
+                continue;
+
+            query.areasIndices[nodeSlice + nodeAreasCount++] = areaIndex;
+            query.foundations[nodeSlice + areaIndex] = MapFoundationType::Undefined;
+        }
+        if(nodeAreasCount == 0)
+            continue;
+        query.visitedNodesCount++;
+
+        if(node.dataOffset > 0)
+            query.nodesWithData.push_back(&node);
+
+        if(node.childrenCount > 0)
+            queryTreeNodesLevel(query, node.firstChild, node.childrenCount, depth + 1, nodeAreasCount);
+
+        for(auto idx = 0; idx < nodeAreasCount; idx++)
+        {
+            const auto areaIndex = query.areasIndices[nodeSlice + idx];
+            const auto childrenFoundation = query.foundations[nodeSlice + areaIndex];
+            auto& foundation = query.foundations[parentSlice + areaIndex];
+
+            const auto foundationToMerge = (childrenFoundation != MapFoundationType::Undefined) ? childrenFoundation : node.foundation;
+            if(foundationToMerge != MapFoundationType::Undefined)
+            {
+                if(foundation == MapFoundationType::Undefined)
+                    foundation = foundationToMerge;
+                else if(foundation != foundationToMerge)
+                    foundation = MapFoundationType::Mixed;
+            }
+        }
+    }
+}
+
+void OsmAnd::ObfMapSectionReader_P::loadMapObjects(
+    const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+    ZoomLevel zoom, const AreaI* bbox31,
+    QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut, MapFoundationType* foundationOut,
+    std::function<bool (const std::shared_ptr<const OsmAnd::Model::MapObject>&)> visitor,
+    IQueryController* controller)
+{
+    const auto area31 = areaOrEverything(bbox31);
+
+    QVector< QList< std::shared_ptr<const OsmAnd::Model::MapObject> > > results;
+    QVector<MapFoundationType> foundations(1, foundationOut ? *foundationOut : MapFoundationType::Undefined);
+    loadMapObjectsForAreas(reader, section, zoom, QVector<AreaI>(1, area31), resultOut ? &results : nullptr, &foundations, visitor, controller);
+
+    if(resultOut)
+        resultOut->append(results.first());
+    if(foundationOut)
+        *foundationOut = foundations.first();
+}
+
+void OsmAnd::ObfMapSectionReader_P::loadMapObjectsForAreas(
+    const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+    ZoomLevel zoom, const QVector<AreaI>& areas31,
+    QVector< QList< std::shared_ptr<const OsmAnd::Model::MapObject> > >* resultsOut, QVector<MapFoundationType>* foundationsOut,
+    std::function<bool (const std::shared_ptr<const OsmAnd::Model::MapObject>&)> visitor,
+    IQueryController* controller)
+{
+    if(areas31.isEmpty())
+        return;
+    if(resultsOut)
+        resultsOut->resize(areas31.size());
+
+    obtainRules(reader, section);
+
+    // Geometry of all objects is decoded into buffers owned by this query, and each object
+    // receives exactly-sized copy, instead of growing its own vectors point by point
+    DecodingBuffers scratch;
+    scratch.geometrySimplificationTolerance = getGeometrySimplificationTolerance();
+    scratch.simplificationTolerance31 = 0;
+    const auto statistics = controller ? controller->getStatistics() : nullptr;
+    scratch.collectStatistics = (statistics != nullptr);
+
+    // Blocks are decoded once for area that covers all requested ones, and then objects are split between areas
+    auto unitedArea31 = areas31.first();
+    for(auto itArea31 = areas31.cbegin(); itArea31 != areas31.cend(); ++itArea31)
+    {
+        const auto& area31 = *itArea31;
+
+        unitedArea31.top = qMin(unitedArea31.top, area31.top);
+        unitedArea31.left = qMin(unitedArea31.left, area31.left);
+        unitedArea31.bottom = qMax(unitedArea31.bottom, area31.bottom);
+        unitedArea31.right = qMax(unitedArea31.right, area31.right);
+    }
+
+    QVector<MapFoundationType> foundations(areas31.size(), MapFoundationType::Undefined);
+    if(foundationsOut && foundationsOut->size() == areas31.size())
+        foundations = *foundationsOut;
+
+    QVector<int> blockAreasIndices;
+    QList< std::shared_ptr<const OsmAnd::Model::MapObject> > blockMapObjects;
+    for(auto itMapLevel = section->_levels.begin(); itMapLevel != section->_levels.end(); ++itMapLevel)
+    {
+        const auto& mapLevel = *itMapLevel;
+
+        if(mapLevel->_minZoom > zoom || mapLevel->_maxZoom < zoom)
+            continue;
+
+        const auto shouldSkip =
+            !unitedArea31.contains(mapLevel->_area31) &&
+            !mapLevel->_area31.contains(unitedArea31) &&
+            !unitedArea31.intersects(mapLevel->_area31);
+        if(shouldSkip)
+            continue;
+
+        const QueryStatistics::Stopwatch treeTraversalStopwatch(scratch.collectStatistics);
+        const auto treeIndex = obtainTreeIndex(reader, section, mapLevel);
+        QList< const ObfMapSectionLevel_P::TreeIndex::Node* > treeNodesWithData;
+        unsigned int visitedNodesCount = 0;
+        queryTreeNodesForAreas(*treeIndex, areas31, foundations, treeNodesWithData, &visitedNodesCount);
+        scratch.statistics.treeNodesVisited += visitedNodesCount;
+        scratch.statistics.treeTraversalTime += treeTraversalStopwatch.elapsed();
+
+        for(auto itTreeNode = treeNodesWithData.begin(); itTreeNode != treeNodesWithData.end(); ++itTreeNode)
+        {
+            const auto& treeNode = **itTreeNode;
+            if(controller && controller->isAborted())
+                break;
+
+            const auto blockLength = obtainMapObjectsBlock(reader, section, *mapLevel, zoom, treeNode, unitedArea31,
+                scratch, blockMapObjects, controller);
+
+            // Objects of block may only belong to areas that intersect block's node
+            blockAreasIndices.clear();
+            for(auto areaIdx = 0; areaIdx < areas31.size(); areaIdx++)
+            {
+                const auto& area31 = areas31[areaIdx];
+                const auto intersects =
+                    area31.contains(treeNode.area31) ||
+                    treeNode.area31.contains(area31) ||
+                    area31.intersects(treeNode.area31);
+                if(intersects)
+                    blockAreasIndices.push_back(areaIdx);
+            }
+
+            // Same instance of map object is given to each area it intersects
+            unsigned int blockObjectsCount = 0;
+            for(auto itMapObject = blockMapObjects.cbegin(); itMapObject != blockMapObjects.cend(); ++itMapObject)
+            {
+                const auto& mapObject = *itMapObject;
+
+                auto intersectsAnyArea = false;
+                for(auto itAreaIndex = blockAreasIndices.cbegin(); itAreaIndex != blockAreasIndices.cend(); ++itAreaIndex)
+                {
+                    if(!areas31[*itAreaIndex].intersects(mapObject->bbox31))
+                        continue;
+                    intersectsAnyArea = true;
+                    break;
+                }
+                if(!intersectsAnyArea || (visitor && !visitor(mapObject)))
+                {
+                    scratch.statistics.objectsDiscarded++;
+                    continue;
+                }
+
+                if(resultsOut)
+                {
+                    for(auto itAreaIndex = blockAreasIndices.cbegin(); itAreaIndex != blockAreasIndices.cend(); ++itAreaIndex)
+                    {
+                        if(areas31[*itAreaIndex].intersects(mapObject->bbox31))
+                            (*resultsOut)[*itAreaIndex].push_back(mapObject);
+                    }
+                }
+                blockObjectsCount++;
+            }
+
+            if(controller)
+                controller->onBlockProcessed(blockObjectsCount, blockLength);
+        }
+    }
+
+    if(statistics)
+        statistics->add(scratch.statistics);
+
+    if(foundationsOut)
+        *foundationsOut = foundations;
+}
+
+uint32_t OsmAnd::ObfMapSectionReader_P::obtainMapObjectsBlock(
+    const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+    const ObfMapSectionLevel& mapLevel, const ZoomLevel zoom,
+    const ObfMapSectionLevel_P::TreeIndex::Node& treeNode, const AreaI& bbox31,
+    DecodingBuffers& scratch,
+    QList< std::shared_ptr<const OsmAnd::Model::MapObject> >& mapObjectsOut,
+    IQueryController* controller)
+{
+    auto cis = reader->_codedInputStream.get();
+
+    const auto& dataBlocksCache = ObfMapSectionDataBlocksCache::instance;
+    const auto useDataBlocksCache = dataBlocksCache->isEnabled();
+
+    mapObjectsOut.clear();
+    if(useDataBlocksCache)
+    {
+        const auto dataBlock = dataBlocksCache->obtainBlock(section, treeNode.dataOffset, scratch.geometrySimplificationTolerance);
+        if(dataBlock)
+        {
+            mapObjectsOut = dataBlock->mapObjects;
+            return 0;
+        }
+    }
+
+    const QueryStatistics::Stopwatch blockDecodingStopwatch(scratch.collectStatistics);
+    cis->Seek(treeNode.dataOffset);
+    gpb::uint32 length;
+    cis->ReadVarint32(&length);
+    auto oldLimit = cis->PushLimit(length);
+    if(useDataBlocksCache)
+    {
+        // Cached block has to contain all objects, so it's decoded without bbox. It's also shared
+        // by all zooms of level, so it may be simplified only as much as the most detailed zoom allows
+        scratch.simplificationTolerance31 = getSimplificationTolerance31(scratch.geometrySimplificationTolerance, mapLevel._maxZoom);
+        std::shared_ptr<ObfMapSectionDataBlocksCache::Block> newDataBlock(new ObfMapSectionDataBlocksCache::Block(section, scratch.geometrySimplificationTolerance));
+        readMapObjectsBlock(reader, section, treeNode, &newDataBlock->mapObjects, nullptr, scratch, nullptr, controller);
+
+        // Block of aborted query may be incomplete
+        if(!controller || !controller->isAborted())
+            dataBlocksCache->putBlock(section, treeNode.dataOffset, newDataBlock);
+        mapObjectsOut = newDataBlock->mapObjects;
+    }
+    else
+    {
+        scratch.simplificationTolerance31 = getSimplificationTolerance31(scratch.geometrySimplificationTolerance, zoom);
+        readMapObjectsBlock(reader, section, treeNode, &mapObjectsOut, &bbox31, scratch, nullptr, controller);
+    }
+    assert(cis->BytesUntilLimit() == 0);
+    cis->PopLimit(oldLimit);
+
+    scratch.statistics.seeksCount++;
+    scratch.statistics.blocksRead++;
+    scratch.statistics.bytesRead += length;
+    scratch.statistics.blocksDecodingTime += blockDecodingStopwatch.elapsed();
+
+    return length;
+}
+
+void OsmAnd::ObfMapSectionReader_P::scanMapObjects(
+    const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+    ZoomLevel zoom, const AreaI* bbox31,
+    std::function<bool (const ObfMapSectionReader::MapObjectView&)> visitor,
+    QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* promotedOut, MapFoundationType* foundationOut,
+    IQueryController* controller)
+{
+    auto cis = reader->_codedInputStream.get();
+
+    obtainRules(reader, section);
+
+    // Buffers are allocated once per scan and reused by every map object
+    DecodingBuffers scratch;
+    scratch.geometrySimplificationTolerance = getGeometrySimplificationTolerance();
+    scratch.simplificationTolerance31 = getSimplificationTolerance31(scratch.geometrySimplificationTolerance, zoom);
+    const auto statistics = controller ? controller->getStatistics() : nullptr;
+    scratch.collectStatistics = (statistics != nullptr);
+
+    auto foundation = MapFoundationType::Undefined;
+    if(foundationOut)
+        foundation = *foundationOut;
+    for(auto itMapLevel = section->_levels.begin(); itMapLevel != section->_levels.end(); ++itMapLevel)
+    {
+        const auto& mapLevel = *itMapLevel;
+
+        if(mapLevel->_minZoom > zoom || mapLevel->_maxZoom < zoom)
+            continue;
+
+        if(bbox31)
+        {
+            const auto shouldSkip =
+                !bbox31->contains(mapLevel->_area31) &&
+                !mapLevel->_area31.contains(*bbox31) &&
+                !bbox31->intersects(mapLevel->_area31);
+            if(shouldSkip)
+                continue;
+        }
+
+        const QueryStatistics::Stopwatch treeTraversalStopwatch(scratch.collectStatistics);
+        const auto treeIndex = obtainTreeIndex(reader, section, mapLevel);
+        QList< const ObfMapSectionLevel_P::TreeIndex::Node* > treeNodesWithData;
+        unsigned int visitedNodesCount = 0;
+        queryTreeNodes(*treeIndex, bbox31, treeNodesWithData, foundation, &visitedNodesCount);
+        scratch.statistics.treeNodesVisited += visitedNodesCount;
+        scratch.statistics.treeTraversalTime += treeTraversalStopwatch.elapsed();
+
+        // Views always point to freshly decoded data, so shared data blocks cache is bypassed
+        for(auto itTreeNode = treeNodesWithData.begin(); itTreeNode != treeNodesWithData.end(); ++itTreeNode)
+        {
+            const auto& treeNode = **itTreeNode;
+            if(controller && controller->isAborted())
+                break;
+
+            const QueryStatistics::Stopwatch blockDecodingStopwatch(scratch.collectStatistics);
+            cis->Seek(treeNode.dataOffset);
+            gpb::uint32 length;
+            cis->ReadVarint32(&length);
+            auto oldLimit = cis->PushLimit(length);
+            const auto visitedCount = scanMapObjectsBlock(reader, section, treeNode, bbox31, scratch, visitor, promotedOut, controller);
+            assert(cis->BytesUntilLimit() == 0);
+            cis->PopLimit(oldLimit);
+
+            scratch.statistics.seeksCount++;
+            scratch.statistics.blocksRead++;
+            scratch.statistics.bytesRead += length;
+            scratch.statistics.blocksDecodingTime += blockDecodingStopwatch.elapsed();
+
+            if(controller)
+                controller->onBlockProcessed(visitedCount, length);
+        }
+    }
+
+    if(statistics)
+        statistics->add(scratch.statistics);
+
+    if(foundationOut)
+        *foundationOut = foundation;
+}
+
+unsigned int OsmAnd::ObfMapSectionReader_P::scanMapObjectsBlock(
+    const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+    const ObfMapSectionLevel_P::TreeIndex::Node& treeNode,
+    const AreaI* bbox31,
+    DecodingBuffers& scratch,
+    std::function<bool (const ObfMapSectionReader::MapObjectView&)> visitor,
+    QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* promotedOut,
+    IQueryController* controller)
+{
+    auto cis = reader->_codedInputStream.get();
+
+    QList< std::shared_ptr<OsmAnd::Model::MapObject> > promotedObjects;
+    const std::shared_ptr<ObfStringTable> mapObjectsNamesTable(new ObfStringTable());
+    gpb::uint64 baseId = 0;
+    unsigned int visitedCount = 0;
+    for(;;)
+    {
+        // Rest of block is skipped, so caller still finds stream at the end of block's limit
+        if(controller && controller->isAborted())
+        {
+            cis->Skip(cis->BytesUntilLimit());
+            return visitedCount;
+        }
+
+        auto tag = cis->ReadTag();
+        switch(gpb::internal::WireFormatLite::GetTagFieldNumber(tag))
+        {
+        case 0:
+            // String table is stored after all objects, so names of promoted objects are filled only now
+            for(auto itEntry = promotedObjects.begin(); itEntry != promotedObjects.end(); ++itEntry)
+            {
+                const auto& entry = *itEntry;
+
+                attachMapObjectNames(section, mapObjectsNamesTable, entry);
+                promotedOut->push_back(entry);
+            }
+            return visitedCount;
+        case OBF::MapDataBlock::kBaseIdFieldNumber:
+            cis->ReadVarint64(&baseId);
+            break;
+        case OBF::MapDataBlock::kDataObjectsFieldNumber:
+            {
+                gpb::uint32 length;
+                cis->ReadVarint32(&length);
+                auto oldLimit = cis->PushLimit(length);
+                if(readMapObjectView(reader, section, treeNode, baseId, scratch, bbox31))
+                {
+                    visitedCount++;
+                    scratch.statistics.objectsDecoded++;
+                    const auto shouldPromote = !visitor || visitor(scratch.view);
+                    if(shouldPromote && promotedOut)
+                        promotedObjects.push_back(promoteMapObjectView(section, scratch.view));
+                }
+                else
+                    scratch.statistics.objectsDiscarded++;
+                assert(cis->BytesUntilLimit() == 0);
+                cis->PopLimit(oldLimit);
+            }
+            break;
+        case OBF::MapDataBlock::kStringTableFieldNumber:
+            {
+                gpb::uint32 length;
+                cis->ReadVarint32(&length);
+                auto oldLimit = cis->PushLimit(length);
+                if(promotedObjects.isEmpty())
+                {
+                    cis->Skip(cis->BytesUntilLimit());
+                    cis->PopLimit(oldLimit);
+                    break;
+                }
+                const QueryStatistics::Stopwatch stringTableStopwatch(scratch.collectStatistics);
+                mapObjectsNamesTable->read(cis);
+                scratch.statistics.stringTablesReadingTime += stringTableStopwatch.elapsed();
+                assert(cis->BytesUntilLimit() == 0);
+                cis->PopLimit(oldLimit);
+            }
+            break;
+        default:
+            ObfReaderUtilities::skipUnknownField(cis, tag);
+            break;
+        }
+    }
+}
+
+bool OsmAnd::ObfMapSectionReader_P::readMapObjectView(
+    const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+    const ObfMapSectionLevel_P::TreeIndex::Node& treeNode,
     uint64_t baseId,
-    std::shared_ptr<OsmAnd::Model::MapObject>& mapObject,
+    DecodingBuffers& scratch,
     const AreaI* bbox31)
 {
     auto cis = reader->_codedInputStream.get();
 
+    // clear() keeps capacity, so after first few objects no allocations are made
+    scratch.points31.clear();
+    scratch.innerPolygonsPoints31.clear();
+    scratch.innerPolygonsSizes.clear();
+    scratch.typesRuleIds.clear();
+    scratch.extraTypesRuleIds.clear();
+    scratch.namesIds.clear();
+
+    auto& view = scratch.view;
+    view.id = 0;
+    view.isArea = false;
+    view.foundation = treeNode.foundation;
+
+    bool hasCoordinates = false;
     for(;;)
     {
         auto tag = cis->ReadTag();
@@ -512,50 +1093,67 @@ void OsmAnd::ObfMapSectionReader_P::readMapObject(
         switch(tgn)
         {
         case 0:
-            if(mapObject && mapObject->points31.isEmpty())
+            if(!hasCoordinates)
+                return false;
+            if(scratch.points31.empty())
             {
                 LogPrintf(LogSeverityLevel::Warning,
                     "Empty MapObject #%" PRIu64 "(%" PRIi64 ") detected in section '%s'",
-                    mapObject->id >> 1, static_cast<int64_t>(mapObject->id) / 2,
+                    view.id >> 1, static_cast<int64_t>(view.id) / 2,
                     qPrintable(section->name));
-                mapObject.reset();
+                return false;
             }
-            return;
+
+            if(scratch.simplificationTolerance31 > 0)
+                simplifyMapObjectGeometry(scratch);
+
+            view.points31 = scratch.points31.data();
+            view.points31Count = static_cast<unsigned int>(scratch.points31.size());
+            view.innerPolygonsPoints31 = scratch.innerPolygonsPoints31.data();
+            view.innerPolygonsSizes = scratch.innerPolygonsSizes.data();
+            view.innerPolygonsCount = static_cast<unsigned int>(scratch.innerPolygonsSizes.size());
+            view.typesRuleIds = scratch.typesRuleIds.data();
+            view.typesCount = static_cast<unsigned int>(scratch.typesRuleIds.size());
+            view.extraTypesRuleIds = scratch.extraTypesRuleIds.data();
+            view.extraTypesCount = static_cast<unsigned int>(scratch.extraTypesRuleIds.size());
+            view.namesIds = scratch.namesIds.data();
+            view.namesCount = static_cast<unsigned int>(scratch.namesIds.size() / 2);
+            return true;
         case OBF::MapData::kAreaCoordinatesFieldNumber:
         case OBF::MapData::kCoordinatesFieldNumber:
             {
-                QVector< PointI > points31;
                 gpb::uint32 length;
                 cis->ReadVarint32(&length);
                 auto oldLimit = cis->PushLimit(length);
 
-                PointI p;
-                p.x = treeNode->_area31.left & MaskToRead;
-                p.y = treeNode->_area31.top & MaskToRead;
+                const PointI base31(
+                    treeNode.area31.left & MaskToRead,
+                    treeNode.area31.top & MaskToRead);
 
                 AreaI objectBBox;
                 objectBBox.top = objectBBox.left = std::numeric_limits<int32_t>::max();
                 objectBBox.bottom = objectBBox.right = 0;
 
-                bool shouldNotSkip = (bbox31 == nullptr);
-                while(cis->BytesUntilLimit() > 0)
+                // Objects of nodes that are entirely inside query bbox can not miss it, so they are not checked at all.
+                // In border nodes, raw deltas are scanned first tracking only running bbox: scan stops at first point
+                // that proves object intersects query bbox, and object that never does is skipped without decoding
+                const auto isBorderNode = (bbox31 != nullptr) && !bbox31->contains(treeNode.area31);
+                if(isBorderNode && !ObfReaderUtilities::mayCoordinatesIntersect(cis, base31, ShiftCoordinates, *bbox31))
                 {
-                    PointI d;
-                    d.x = (ObfReaderUtilities::readSInt32(cis) << ShiftCoordinates);
-                    d.y = (ObfReaderUtilities::readSInt32(cis) << ShiftCoordinates);
-
-                    p += d;
-                    points31.push_back(p);
-
-                    if(!shouldNotSkip && bbox31)
-                        shouldNotSkip = bbox31->contains(p);
-                    objectBBox.enlargeToInclude(p);
+                    cis->PopLimit(oldLimit);
+                    cis->Skip(cis->BytesUntilLimit());
+                    return false;
                 }
-                if(points31.isEmpty())
+
+                // Points and their bbox are decoded in single pass into reused buffer. Bbox is still checked,
+                // since scan above proves nothing when raw buffer is not available
+                ObfReaderUtilities::readCoordinates(cis, base31, ShiftCoordinates, scratch.points31, objectBBox);
+                bool shouldNotSkip = !isBorderNode;
+                if(scratch.points31.empty())
                 {
                     // Fake that this object is inside bbox
                     shouldNotSkip = true;
-                    objectBBox = treeNode->_area31;
+                    objectBBox = treeNode.area31;
                 }
                 if(!shouldNotSkip && bbox31)
                 {
@@ -567,73 +1165,33 @@ void OsmAnd::ObfMapSectionReader_P::readMapObject(
                 if(!shouldNotSkip)
                 {
                     cis->Skip(cis->BytesUntilLimit());
-                    break;
+                    return false;
                 }
 
-                // Finally, create the object
-                if(!mapObject)
-                    mapObject.reset(new OsmAnd::Model::MapObject(section));
-                mapObject->_isArea = (tgn == OBF::MapData::kAreaCoordinatesFieldNumber);
-                mapObject->_points31 = points31;
-                mapObject->_bbox31 = objectBBox;
-                assert(treeNode->_area31.top - mapObject->_bbox31.top <= 32);
-                assert(treeNode->_area31.left - mapObject->_bbox31.left <= 32);
-                assert(mapObject->_bbox31.bottom - treeNode->_area31.bottom <= 1);
-                assert(mapObject->_bbox31.right - treeNode->_area31.right <= 1);
-                assert(mapObject->_bbox31.right >= mapObject->_bbox31.left);
-                assert(mapObject->_bbox31.bottom >= mapObject->_bbox31.top);
+                hasCoordinates = true;
+                view.isArea = (tgn == OBF::MapData::kAreaCoordinatesFieldNumber);
+                view.bbox31 = objectBBox;
             }
             break;
         case OBF::MapData::kPolygonInnerCoordinatesFieldNumber:
             {
-                if(!mapObject)
-                    mapObject.reset(new OsmAnd::Model::MapObject(section));
-
                 gpb::uint32 length;
                 cis->ReadVarint32(&length);
                 auto oldLimit = cis->PushLimit(length);
-                auto px = treeNode->_area31.left & MaskToRead;
-                auto py = treeNode->_area31.top & MaskToRead;
-                mapObject->_innerPolygonsPoints31.push_back(QVector< PointI >());
-                auto& polygon = mapObject->_innerPolygonsPoints31.last();
-                while(cis->BytesUntilLimit() > 0)
-                {
-                    auto dx = (ObfReaderUtilities::readSInt32(cis) << ShiftCoordinates);
-                    auto x = dx + px;
-                    auto dy = (ObfReaderUtilities::readSInt32(cis) << ShiftCoordinates);
-                    auto y = dy + py;
-
-                    polygon.push_back(PointI(x, y));
-                    
-                    px = x;
-                    py = y;
-                }
+                const auto polygonStart = scratch.innerPolygonsPoints31.size();
+                const PointI base31(
+                    treeNode.area31.left & MaskToRead,
+                    treeNode.area31.top & MaskToRead);
+                AreaI polygonBBox;
+                ObfReaderUtilities::readCoordinates(cis, base31, ShiftCoordinates, scratch.innerPolygonsPoints31, polygonBBox);
+                scratch.innerPolygonsSizes.push_back(static_cast<unsigned int>(scratch.innerPolygonsPoints31.size() - polygonStart));
                 cis->PopLimit(oldLimit);
             }
             break;
         case OBF::MapData::kAdditionalTypesFieldNumber:
-            {
-                if(!mapObject)
-                    mapObject.reset(new OsmAnd::Model::MapObject(section));
-
-                gpb::uint32 length;
-                cis->ReadVarint32(&length);
-                auto oldLimit = cis->PushLimit(length);
-                while(cis->BytesUntilLimit() > 0)
-                {
-                    gpb::uint32 type;
-                    cis->ReadVarint32(&type);
-
-                    const auto& tagValue = section->_d->_rules->_decodingRules[type];
-                    mapObject->_extraTypes.push_back(TagValue(std::get<0>(tagValue), std::get<1>(tagValue)));
-                }
-                cis->PopLimit(oldLimit);
-            }
-            break;
         case OBF::MapData::kTypesFieldNumber:
             {
-                if(!mapObject)
-                    mapObject.reset(new OsmAnd::Model::MapObject(section));
+                auto& ruleIds = (tgn == OBF::MapData::kTypesFieldNumber) ? scratch.typesRuleIds : scratch.extraTypesRuleIds;
 
                 gpb::uint32 length;
                 cis->ReadVarint32(&length);
@@ -642,9 +1200,7 @@ void OsmAnd::ObfMapSectionReader_P::readMapObject(
                 {
                     gpb::uint32 type;
                     cis->ReadVarint32(&type);
-
-                    const auto& tagValue = section->_d->_rules->_decodingRules[type];
-                    mapObject->_types.push_back(TagValue(std::get<0>(tagValue), std::get<1>(tagValue)));
+                    ruleIds.push_back(type);
                 }
                 cis->PopLimit(oldLimit);
             }
@@ -665,8 +1221,8 @@ void OsmAnd::ObfMapSectionReader_P::readMapObject(
                     ok = cis->ReadVarint32(&stringId);
                     assert(ok);
 
-                    const auto& tagName = std::get<0>(section->_d->_rules->_decodingRules[stringTag]);
-                    mapObject->_names.insert(tagName, ObfReaderUtilities::encodeIntegerToString(stringId));
+                    scratch.namesIds.push_back(stringTag);
+                    scratch.namesIds.push_back(stringId);
                 }
                 assert(cis->BytesUntilLimit() == 0);
                 cis->PopLimit(oldLimit);
@@ -675,7 +1231,7 @@ void OsmAnd::ObfMapSectionReader_P::readMapObject(
         case OBF::MapData::kIdFieldNumber:
             {
                 auto d = ObfReaderUtilities::readSInt64(cis);
-                mapObject->_id = d + baseId;
+                view.id = d + baseId;
             }
             break;
         default:
@@ -685,122 +1241,165 @@ void OsmAnd::ObfMapSectionReader_P::readMapObject(
     }
 }
 
-void OsmAnd::ObfMapSectionReader_P::loadMapObjects(
-    const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
-    ZoomLevel zoom, const AreaI* bbox31,
-    QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut, MapFoundationType* foundationOut,
-    std::function<bool (const std::shared_ptr<const OsmAnd::Model::MapObject>&)> visitor,
-    IQueryController* controller)
+unsigned int OsmAnd::ObfMapSectionReader_P::simplifyPoints(
+    PointI* points31, const unsigned int count, const uint32_t tolerance31, const bool isRing)
 {
-    auto cis = reader->_codedInputStream.get();
+    // Ring has to remain at least a triangle (plus closing point), and polyline has to keep both ends
+    const unsigned int minCount = isRing ? 4 : 2;
+    if(count <= minCount)
+        return count;
 
-    // Check if this map section has initialized rules
-    {
-        QMutexLocker scopedLock(&section->_d->_rulesMutex);
+    // Vertex is kept only if it's farther than tolerance from previously kept one in any axis.
+    // First and last vertices are always kept, so closed rings stay closed and
+    // coastline segments can still be joined by their ends
+    const auto shouldKeep =
+        [tolerance31](const PointI& lastKept, const PointI& p) -> bool
+        {
+            const auto dx = std::abs(static_cast<int64_t>(p.x) - lastKept.x);
+            const auto dy = std::abs(static_cast<int64_t>(p.y) - lastKept.y);
+            return (dx > tolerance31 || dy > tolerance31);
+        };
 
-        if(!section->_d->_rules)
+    // Ring that would become degenerate is left as-is, so check before overwriting anything
+    if(isRing)
+    {
+        unsigned int keptCount = 2;
+        auto lastKept = points31[0];
+        for(unsigned int idx = 1; idx < count - 1 && keptCount < minCount; idx++)
         {
-            cis->Seek(section->_offset);
-            auto oldLimit = cis->PushLimit(section->_length);
-            section->_d->_rules.reset(new ObfMapSectionInfo_P::Rules());
-            readRules(reader, section->_d->_rules);
-            cis->PopLimit(oldLimit);
+            if(!shouldKeep(lastKept, points31[idx]))
+                continue;
+            lastKept = points31[idx];
+            keptCount++;
         }
+        if(keptCount < minCount)
+            return count;
     }
-    
-    auto foundation = MapFoundationType::Undefined;
-    if(foundationOut)
-        foundation = *foundationOut;
-    for(auto itMapLevel = section->_levels.begin(); itMapLevel != section->_levels.end(); ++itMapLevel)
-    {
-        const auto& mapLevel = *itMapLevel;
 
-        if(mapLevel->_minZoom > zoom || mapLevel->_maxZoom < zoom)
+    unsigned int keptCount = 1;
+    for(unsigned int idx = 1; idx < count - 1; idx++)
+    {
+        if(!shouldKeep(points31[keptCount - 1], points31[idx]))
             continue;
+        points31[keptCount++] = points31[idx];
+    }
+    points31[keptCount++] = points31[count - 1];
 
-        if(bbox31)
-        {
-            const auto shouldSkip =
-                !bbox31->contains(mapLevel->_area31) &&
-                !mapLevel->_area31.contains(*bbox31) &&
-                !bbox31->intersects(mapLevel->_area31);
-            if(shouldSkip)
-                continue;
-        }
+    return keptCount;
+}
 
-        // If there are no tree nodes in map level, it means they are not loaded
-        {
-            QMutexLocker scopedLock(&mapLevel->_d->_rootNodesMutex);
+void OsmAnd::ObfMapSectionReader_P::simplifyMapObjectGeometry( DecodingBuffers& scratch )
+{
+    const auto tolerance31 = scratch.simplificationTolerance31;
 
-            if(!mapLevel->_d->_rootNodes)
-            {
-                cis->Seek(mapLevel->_offset);
-                auto oldLimit = cis->PushLimit(mapLevel->_length);
-                cis->Skip(mapLevel->_boxesInnerOffset);
-                mapLevel->_d->_rootNodes.reset(new ObfMapSectionLevel_P::RootNodes());
-                readMapLevelTreeNodes(reader, section, mapLevel, mapLevel->_d->_rootNodes->nodes);
-                cis->PopLimit(oldLimit);
-            }
-        }
-        
-        QList< std::shared_ptr<ObfMapSectionLevelTreeNode> > treeNodesWithData;
-        for(auto itRootNode = mapLevel->_d->_rootNodes->nodes.begin(); itRootNode != mapLevel->_d->_rootNodes->nodes.end(); ++itRootNode)
-        {
-            const auto& rootNode = *itRootNode;
+    auto& points31 = scratch.points31;
+    const auto pointsCount = static_cast<unsigned int>(points31.size());
+    const auto isRing = scratch.view.isArea || (pointsCount > 1 && points31.front() == points31.back());
+    points31.resize(simplifyPoints(points31.data(), pointsCount, tolerance31, isRing));
 
-            if(bbox31)
-            {
-                const auto shouldSkip =
-                    !bbox31->contains(rootNode->_area31) &&
-                    !rootNode->_area31.contains(*bbox31) &&
-                    !bbox31->intersects(rootNode->_area31);
-                if(shouldSkip)
-                    continue;
-            }
+    // Inner polygons are compacted in-place, one ring after another
+    auto& innerPoints31 = scratch.innerPolygonsPoints31;
+    unsigned int readOffset = 0;
+    unsigned int writeOffset = 0;
+    for(auto itSize = scratch.innerPolygonsSizes.begin(); itSize != scratch.innerPolygonsSizes.end(); ++itSize)
+    {
+        auto& ringSize = *itSize;
+        if(writeOffset != readOffset)
+            std::copy(innerPoints31.begin() + readOffset, innerPoints31.begin() + readOffset + ringSize, innerPoints31.begin() + writeOffset);
+        readOffset += ringSize;
 
-            if(rootNode->_dataOffset > 0)
-                treeNodesWithData.push_back(rootNode);
+        const auto newRingSize = simplifyPoints(innerPoints31.data() + writeOffset, ringSize, tolerance31, true);
+        writeOffset += newRingSize;
+        ringSize = newRingSize;
+    }
+    innerPoints31.resize(writeOffset);
+}
 
-            auto childrenFoundation = MapFoundationType::Undefined;
-            if(rootNode->_childrenInnerOffset > 0)
-            {
-                cis->Seek(rootNode->_offset);
-                auto oldLimit = cis->PushLimit(rootNode->_length);
-                cis->Skip(rootNode->_childrenInnerOffset);
-                readTreeNodeChildren(reader, section, rootNode, childrenFoundation, &treeNodesWithData, bbox31, controller);
-                assert(cis->BytesUntilLimit() == 0);
-                cis->PopLimit(oldLimit);
-            }
+std::shared_ptr<OsmAnd::Model::MapObject> OsmAnd::ObfMapSectionReader_P::promoteMapObjectView(
+    const std::shared_ptr<const ObfMapSectionInfo>& section, const ObfMapSectionReader::MapObjectView& view)
+{
+    const auto& rules = section->_d->_rules;
 
-            const auto foundationToMerge = (childrenFoundation != MapFoundationType::Undefined) ? childrenFoundation : rootNode->_foundation;
-            if(foundationToMerge != MapFoundationType::Undefined)
-            {
-                if(foundation == MapFoundationType::Undefined)
-                    foundation = foundationToMerge;
-                else if(foundation != foundationToMerge)
-                    foundation = MapFoundationType::Mixed;
-            }
-        }
-        qSort(treeNodesWithData.begin(), treeNodesWithData.end(), [](const std::shared_ptr<ObfMapSectionLevelTreeNode>& l, const std::shared_ptr<ObfMapSectionLevelTreeNode>& r) -> bool
-        {
-            return l->_dataOffset < r->_dataOffset;
-        });
-        for(auto itTreeNode = treeNodesWithData.begin(); itTreeNode != treeNodesWithData.end(); ++itTreeNode)
-        {
-            const auto& treeNode = *itTreeNode;
-            if(controller && controller->isAborted())
-                break;
+    std::shared_ptr<OsmAnd::Model::MapObject> mapObject(new OsmAnd::Model::MapObject(section, rules));
+    mapObject->_id = view.id;
+    mapObject->_isArea = view.isArea;
+    mapObject->_foundation = view.foundation;
+    mapObject->_bbox31 = view.bbox31;
 
-            cis->Seek(treeNode->_dataOffset);
-            gpb::uint32 length;
-            cis->ReadVarint32(&length);
-            auto oldLimit = cis->PushLimit(length);
-            readMapObjectsBlock(reader, section, treeNode, resultOut, bbox31, visitor, controller);
-            assert(cis->BytesUntilLimit() == 0);
-            cis->PopLimit(oldLimit);
-        }
+    mapObject->_points31.resize(view.points31Count);
+    std::copy(view.points31, view.points31 + view.points31Count, mapObject->_points31.begin());
+
+    mapObject->_innerPolygonsPoints31.reserve(view.innerPolygonsCount);
+    auto pInnerPoint = view.innerPolygonsPoints31;
+    for(auto polygonIdx = 0u; polygonIdx < view.innerPolygonsCount; polygonIdx++)
+    {
+        const auto pointsCount = view.innerPolygonsSizes[polygonIdx];
+        QVector< PointI > polygon(pointsCount);
+        std::copy(pInnerPoint, pInnerPoint + pointsCount, polygon.begin());
+        mapObject->_innerPolygonsPoints31.push_back(polygon);
+        pInnerPoint += pointsCount;
     }
 
-    if(foundationOut)
-        *foundationOut = foundation;
+    // Types are kept as rule ids, and resolved via rules shared by entire section
+    mapObject->_typesRuleIds.resize(view.typesCount);
+    std::copy(view.typesRuleIds, view.typesRuleIds + view.typesCount, mapObject->_typesRuleIds.begin());
+    mapObject->_extraTypesRuleIds.resize(view.extraTypesCount);
+    std::copy(view.extraTypesRuleIds, view.extraTypesRuleIds + view.extraTypesCount, mapObject->_extraTypesRuleIds.begin());
+
+    // String table of data block is attached once it's read
+    mapObject->_namesIds.resize(view.namesCount);
+    for(auto nameIdx = 0u; nameIdx < view.namesCount; nameIdx++)
+    {
+        auto& nameId = mapObject->_namesIds[nameIdx];
+        nameId.first = view.namesIds[nameIdx*2 + 0];
+        nameId.second = view.namesIds[nameIdx*2 + 1];
+    }
+
+    return mapObject;
+}
+
+bool OsmAnd::ObfMapSectionReader_P::decodeRule(
+    const std::shared_ptr<const ObfMapSectionInfo>& section, uint32_t ruleId, TagValue& outTagValue)
+{
+    std::shared_ptr<const ObfMapSectionInfo_P::Rules> rules;
+    {
+        QMutexLocker scopedLock(&section->_d->_rulesMutex);
+        rules = section->_d->_rules;
+    }
+    if(!rules)
+        return false;
+
+    if(!(rules->getRuleFlags(ruleId) & ObfMapSectionInfo_P::Rules::IsDefined))
+        return false;
+
+    outTagValue = rules->decodingRules[ruleId].tagValue;
+    return true;
+}
+
+bool OsmAnd::ObfMapSectionReader_P::setGeometrySimplificationTolerance( const float tolerance )
+{
+    QMutexLocker scopedLocker(&_geometrySimplificationToleranceMutex);
+
+    const auto newTolerance = std::max(tolerance, 0.0f);
+    if(qFuzzyCompare(1.0f + _geometrySimplificationTolerance, 1.0f + newTolerance))
+        return false;
+    _geometrySimplificationTolerance = newTolerance;
+    return true;
+}
+
+float OsmAnd::ObfMapSectionReader_P::getGeometrySimplificationTolerance()
+{
+    QMutexLocker scopedLocker(&_geometrySimplificationToleranceMutex);
+
+    return _geometrySimplificationTolerance;
+}
+
+uint32_t OsmAnd::ObfMapSectionReader_P::getSimplificationTolerance31( const float tolerance, const ZoomLevel zoom )
+{
+    if(tolerance <= 0.0f)
+        return 0;
+
+    // Single pixel of 256x256 tile at given zoom takes 2^(31 - 8 - zoom) units in 31-bit coordinates
+    const auto tolerance31 = std::ldexp(static_cast<double>(tolerance), 23 - static_cast<int>(zoom));
+    return static_cast<uint32_t>(std::min(tolerance31, static_cast<double>(1u << 30)));
 }
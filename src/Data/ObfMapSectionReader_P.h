@@ -26,19 +26,25 @@
 #include <cstdint>
 #include <memory>
 #include <functional>
+#include <vector>
 
 #include <QHash>
 #include <QMap>
 #include <QSet>
+#include <QMutex>
+#include <QVector>
 
 #include <OsmAndCore.h>
 #include <CommonTypes.h>
 #include <ObfMapSectionInfo_P.h>
 #include <MapTypes.h>
+#include <ObfMapSectionReader.h>
+#include <QueryStatistics.h>
 
 namespace OsmAnd {
 
     class ObfReader_P;
+    class ObfStringTable;
     class ObfMapSectionInfo;
     class ObfMapSectionLevel;
     namespace Model {
@@ -66,41 +72,148 @@ namespace OsmAnd {
         static void createRule(const std::shared_ptr<ObfMapSectionInfo_P::Rules>& rules, uint32_t type, uint32_t id, const QString& tag, const QString& val);
 
         static void readMapLevelTreeNodes(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
-            const std::shared_ptr<const ObfMapSectionLevel>& level, QList< std::shared_ptr<ObfMapSectionLevelTreeNode> >& nodes);
+            const std::shared_ptr<const ObfMapSectionLevel>& level, ObfMapSectionLevel_P::TreeIndex& treeIndex);
         static void readTreeNode(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
             const AreaI& parentArea,
             const std::shared_ptr<ObfMapSectionLevelTreeNode>& treeNode);
         static void readTreeNodeChildren(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
             const std::shared_ptr<ObfMapSectionLevelTreeNode>& treeNode,
-            MapFoundationType& foundation,
-            QList< std::shared_ptr<ObfMapSectionLevelTreeNode> >* nodesWithData,
-            const AreaI* bbox31,
-            IQueryController* controller);
+            ObfMapSectionLevel_P::TreeIndex& treeIndex, const uint32_t treeNodeIndex);
+        static void appendTreeNodesToIndex(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+            const QList< std::shared_ptr<ObfMapSectionLevelTreeNode> >& treeNodes,
+            ObfMapSectionLevel_P::TreeIndex& treeIndex);
+
+        // Decoding buffers owned by single query and reused by all map objects it decodes
+        struct DecodingBuffers
+        {
+            ObfMapSectionReader::MapObjectView view;
+            std::vector< PointI > points31;
+            std::vector< PointI > innerPolygonsPoints31;
+            std::vector< unsigned int > innerPolygonsSizes;
+            std::vector< uint32_t > typesRuleIds;
+            std::vector< uint32_t > extraTypesRuleIds;
+            std::vector< uint32_t > namesIds;
+
+            // Read once when query starts, so all blocks of query (and blocks it caches) use same tolerance
+            float geometrySimplificationTolerance;
+            // Set by query for each level, since it depends on zooms level is decoded for
+            uint32_t simplificationTolerance31;
+
+            // Statistics of entire query, that are added to controller's statistics once query ends
+            bool collectStatistics;
+            QueryStatistics::Counters statistics;
+        };
 
-        static void readMapObjectsBlock(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
-            const std::shared_ptr<ObfMapSectionLevelTreeNode>& treeNode,
+        // Returns number of map objects given to resultOut or visitor
+        static unsigned int readMapObjectsBlock(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+            const ObfMapSectionLevel_P::TreeIndex::Node& treeNode,
             QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut,
             const AreaI* bbox31,
+            DecodingBuffers& scratch,
             std::function<bool (const std::shared_ptr<const OsmAnd::Model::MapObject>&)> visitor,
             IQueryController* controller);
 
-        static void readMapObject(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
-            const std::shared_ptr<ObfMapSectionLevelTreeNode>& treeNode,
-            uint64_t baseId,
-            std::shared_ptr<OsmAnd::Model::MapObject>& mapObjectOut,
-            const AreaI* bbox31);
+        static void attachMapObjectNames(const std::shared_ptr<const ObfMapSectionInfo>& section, const std::shared_ptr<const ObfStringTable>& namesTable,
+            const std::shared_ptr<OsmAnd::Model::MapObject>& mapObject);
 
         enum {
             ShiftCoordinates = 5,
             MaskToRead = ~((1u << ShiftCoordinates) - 1),
         };
 
+        static void obtainRules(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section);
+        static std::shared_ptr<const ObfMapSectionLevel_P::TreeIndex> obtainTreeIndex(const std::unique_ptr<ObfReader_P>& reader,
+            const std::shared_ptr<const ObfMapSectionInfo>& section, const std::shared_ptr<const ObfMapSectionLevel>& mapLevel);
+        static void queryTreeNodes(const ObfMapSectionLevel_P::TreeIndex& treeIndex, const AreaI* bbox31,
+            QList< const ObfMapSectionLevel_P::TreeIndex::Node* >& nodesWithData,
+            MapFoundationType& foundation,
+            unsigned int* visitedNodesCount = nullptr);
+        // Same as queryTreeNodes, but for many areas at once: each node is visited once and listed once,
+        // and foundation is merged separately for each area
+        static void queryTreeNodesForAreas(const ObfMapSectionLevel_P::TreeIndex& treeIndex, const QVector<AreaI>& areas31,
+            QVector<MapFoundationType>& foundations,
+            QList< const ObfMapSectionLevel_P::TreeIndex::Node* >& nodesWithData,
+            unsigned int* visitedNodesCount = nullptr);
+
+        // Buffers of single tree query, allocated once and sliced by tree depth: each depth has
+        // a slot for every area, so recursion never allocates
+        struct TreeNodesQuery
+        {
+            TreeNodesQuery(const ObfMapSectionLevel_P::TreeIndex& treeIndex_, const QVector<AreaI>& areas31_,
+                QList< const ObfMapSectionLevel_P::TreeIndex::Node* >& nodesWithData_)
+                : treeIndex(treeIndex_)
+                , areas31(areas31_)
+                , nodesWithData(nodesWithData_)
+                , visitedNodesCount(0)
+            {
+            }
+
+            const ObfMapSectionLevel_P::TreeIndex& treeIndex;
+            const QVector<AreaI>& areas31;
+            QList< const ObfMapSectionLevel_P::TreeIndex::Node* >& nodesWithData;
+            unsigned int visitedNodesCount;
+
+            // Indices of areas that intersect node of each depth
+            QVector<int> areasIndices;
+            // Foundations merged at each depth, by area index
+            QVector<MapFoundationType> foundations;
+        };
+        static void queryTreeNodesLevel(TreeNodesQuery& query,
+            const uint32_t firstNodeIdx, const uint32_t nodesCount,
+            const int depth, const int parentAreasCount);
+
+        // Returns number of views given to visitor
+        static unsigned int scanMapObjectsBlock(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+            const ObfMapSectionLevel_P::TreeIndex::Node& treeNode,
+            const AreaI* bbox31,
+            DecodingBuffers& scratch,
+            std::function<bool (const ObfMapSectionReader::MapObjectView&)> visitor,
+            QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* promotedOut,
+            IQueryController* controller);
+        static bool readMapObjectView(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+            const ObfMapSectionLevel_P::TreeIndex::Node& treeNode,
+            uint64_t baseId,
+            DecodingBuffers& scratch,
+            const AreaI* bbox31);
+        static unsigned int simplifyPoints(PointI* points31, const unsigned int count, const uint32_t tolerance31, const bool isRing);
+        static void simplifyMapObjectGeometry(DecodingBuffers& scratch);
+        static std::shared_ptr<OsmAnd::Model::MapObject> promoteMapObjectView(const std::shared_ptr<const ObfMapSectionInfo>& section,
+            const ObfMapSectionReader::MapObjectView& view);
+
         static void loadMapObjects(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
             ZoomLevel zoom, const AreaI* bbox31,
             QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* resultOut, MapFoundationType* foundationOut,
             std::function<bool (const std::shared_ptr<const OsmAnd::Model::MapObject>&)> visitor,
             IQueryController* controller);
 
+        static void loadMapObjectsForAreas(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+            ZoomLevel zoom, const QVector<AreaI>& areas31,
+            QVector< QList< std::shared_ptr<const OsmAnd::Model::MapObject> > >* resultsOut, QVector<MapFoundationType>* foundationsOut,
+            std::function<bool (const std::shared_ptr<const OsmAnd::Model::MapObject>&)> visitor,
+            IQueryController* controller);
+
+        // Gives map objects of tree node's data block, taken from shared data blocks cache or decoded. Decoded
+        // block is limited to bbox31 unless it's going to be cached. Returns number of bytes read (0 if cached)
+        static uint32_t obtainMapObjectsBlock(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+            const ObfMapSectionLevel& mapLevel, const ZoomLevel zoom,
+            const ObfMapSectionLevel_P::TreeIndex::Node& treeNode, const AreaI& bbox31,
+            DecodingBuffers& scratch,
+            QList< std::shared_ptr<const OsmAnd::Model::MapObject> >& mapObjectsOut,
+            IQueryController* controller);
+
+        static void scanMapObjects(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfMapSectionInfo>& section,
+            ZoomLevel zoom, const AreaI* bbox31,
+            std::function<bool (const ObfMapSectionReader::MapObjectView&)> visitor,
+            QList< std::shared_ptr<const OsmAnd::Model::MapObject> >* promotedOut, MapFoundationType* foundationOut,
+            IQueryController* controller);
+        static bool decodeRule(const std::shared_ptr<const ObfMapSectionInfo>& section, uint32_t ruleId, TagValue& outTagValue);
+
+        static QMutex _geometrySimplificationToleranceMutex;
+        static float _geometrySimplificationTolerance;
+        static bool setGeometrySimplificationTolerance(const float tolerance);
+        static float getGeometrySimplificationTolerance();
+        static uint32_t getSimplificationTolerance31(const float tolerance, const ZoomLevel zoom);
+
     friend class OsmAnd::ObfMapSectionReader;
     friend class OsmAnd::ObfReader_P;
     };
@@ -2,6 +2,7 @@
 #include "ObfPoiSectionReader_P.h"
 
 #include "ObfReader.h"
+#include "ObfReader_P.h"
 
 OsmAnd::ObfPoiSectionReader::ObfPoiSectionReader()
 {
@@ -15,7 +16,8 @@ void OsmAnd::ObfPoiSectionReader::loadCategories(
     const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const OsmAnd::ObfPoiSectionInfo>& section,
     QList< std::shared_ptr<const Model::AmenityCategory> >& categories )
 {
-    ObfPoiSectionReader_P::loadCategories(reader->_d, section, categories);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfPoiSectionReader_P::loadCategories(cursor.reader(), section, categories);
 }
 
 void OsmAnd::ObfPoiSectionReader::loadAmenities(
@@ -24,5 +26,6 @@ void OsmAnd::ObfPoiSectionReader::loadAmenities(
     QList< std::shared_ptr<const OsmAnd::Model::Amenity> >* amenitiesOut /*= nullptr*/,
     std::function<bool (const std::shared_ptr<const OsmAnd::Model::Amenity>&)> visitor /*= nullptr*/, IQueryController* controller /*= nullptr*/ )
 {
-    ObfPoiSectionReader_P::loadAmenities(reader->_d, section, zoom, zoomDepth, bbox31, desiredCategories, amenitiesOut, visitor, controller);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfPoiSectionReader_P::loadAmenities(cursor.reader(), section, zoom, zoomDepth, bbox31, desiredCategories, amenitiesOut, visitor, controller);
 }
@@ -5,6 +5,7 @@
 #include "Amenity.h"
 #include "AmenityCategory.h"
 #include "ObfReaderUtilities.h"
+#include "IQueryController.h"
 #include "Utilities.h"
 
 #include "OBF.pb.h"
@@ -179,21 +180,34 @@ void OsmAnd::ObfPoiSectionReader_P::readAmenities(
 {
     auto cis = reader->_codedInputStream.get();
     QList< std::shared_ptr<Tile> > tiles;
+    const auto statistics = controller ? controller->getStatistics() : nullptr;
+    QueryStatistics::Counters counters;
     for(;;)
     {
         auto tag = cis->ReadTag();
         switch(gpb::internal::WireFormatLite::GetTagFieldNumber(tag))
         {
         case 0:
+            if(statistics)
+                statistics->add(counters);
             return;
         case OBF::OsmAndPoiIndex::kBoxesFieldNumber:
             {
+                const QueryStatistics::Stopwatch treeTraversalStopwatch(statistics != nullptr);
                 auto length = ObfReaderUtilities::readBigEndianInt(cis);
                 auto oldLimit = cis->PushLimit(length);
+                // Boxes may repeat, and tiles of all of them are collected into same list
+                const auto tilesCountBefore = tiles.size();
                 readTile(reader, section, tiles, nullptr, desiredCategories, zoom, zoomDepth, bbox31, controller, nullptr);
                 cis->PopLimit(oldLimit);
+                counters.treeNodesVisited += tiles.size() - tilesCountBefore;
+                counters.treeTraversalTime += treeTraversalStopwatch.elapsed();
                 if(controller && controller->isAborted())
+                {
+                    if(statistics)
+                        statistics->add(counters);
                     return;
+                }
             }
             break;
         case OBF::OsmAndPoiIndex::kPoiDataFieldNumber:
@@ -208,16 +222,28 @@ void OsmAnd::ObfPoiSectionReader_P::readAmenities(
                 {
                     const auto& tile = *itTile;
 
+                    const QueryStatistics::Stopwatch blockDecodingStopwatch(statistics != nullptr);
                     cis->Seek(section->_offset + tile->_offset);
                     auto length = ObfReaderUtilities::readBigEndianInt(cis);
                     auto oldLimit = cis->PushLimit(length);
-                    readAmenitiesFromTile(reader, section, tile.get(), desiredCategories, amenitiesOut, zoom, zoomDepth, bbox31, visitor, controller, nullptr);
+                    const auto amenitiesCount = readAmenitiesFromTile(reader, section, tile.get(), desiredCategories, amenitiesOut, zoom, zoomDepth, bbox31, visitor, controller, nullptr,
+                        statistics ? &counters : nullptr);
                     cis->PopLimit(oldLimit);
-                    if(controller && controller->isAborted())
-                        return;
+                    counters.seeksCount++;
+                    counters.blocksRead++;
+                    counters.bytesRead += length;
+                    counters.blocksDecodingTime += blockDecodingStopwatch.elapsed();
+                    if(controller)
+                    {
+                        controller->onBlockProcessed(amenitiesCount, length);
+                        if(controller->isAborted())
+                            break;
+                    }
                 }
                 cis->Skip(cis->BytesUntilLimit());
             }
+            if(statistics)
+                statistics->add(counters);
             return;
         default:
             ObfReaderUtilities::skipUnknownField(cis, tag);
@@ -398,14 +424,15 @@ bool OsmAnd::ObfPoiSectionReader_P::checkTileCategories(
     }
 }
 
-void OsmAnd::ObfPoiSectionReader_P::readAmenitiesFromTile(
+unsigned int OsmAnd::ObfPoiSectionReader_P::readAmenitiesFromTile(
     const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfPoiSectionInfo>& section, Tile* tile,
     QSet<uint32_t>* desiredCategories,
     QList< std::shared_ptr<const Model::Amenity> >* amenitiesOut,
     const ZoomLevel& zoom, uint32_t zoomDepth, const AreaI* bbox31,
     std::function<bool (const std::shared_ptr<const Model::Amenity>&)> visitor,
     IQueryController* controller,
-    QSet< uint64_t >* amenitiesToSkip)
+    QSet< uint64_t >* amenitiesToSkip,
+    QueryStatistics::Counters* statistics)
 {
     auto cis = reader->_codedInputStream.get();
 
@@ -416,17 +443,18 @@ void OsmAnd::ObfPoiSectionReader_P::readAmenitiesFromTile(
 
     PointI pTile;
     uint32_t zoomTile = 0;
+    unsigned int acceptedCount = 0;
 
     for(;;)
     {
         if(controller && controller->isAborted())
-            return;
+            return acceptedCount;
 
         auto tag = cis->ReadTag();
         switch(gpb::internal::WireFormatLite::GetTagFieldNumber(tag))
         {
         case 0:
-            return;
+            return acceptedCount;
         case OBF::OsmAndPoiBoxData::kZoomFieldNumber:
             {
                 gpb::uint32 value;
@@ -457,12 +485,19 @@ void OsmAnd::ObfPoiSectionReader_P::readAmenitiesFromTile(
                 readAmenity(reader, section, pTile, zoomTile, amenity, desiredCategories, bbox31, controller);
                 cis->PopLimit(oldLimit);
                 if(!amenity)
+                {
+                    if(statistics)
+                        statistics->objectsDiscarded++;
                     break;
+                }
+                if(statistics)
+                    statistics->objectsDecoded++;
                 if(amenitiesToSkip)
                 {
                     const auto xp = amenity->_point31.x >> (31 - zoomToSkip);
                     const auto yp = amenity->_point31.y >> (31 - zoomToSkip);
                     const auto hash = (static_cast<uint64_t>(xp) << zoomToSkip) | static_cast<uint64_t>(yp);
+                    auto accepted = false;
                     if(!amenitiesToSkip->contains(hash))
                     {
                         if(!visitor || visitor(amenity))
@@ -470,12 +505,16 @@ void OsmAnd::ObfPoiSectionReader_P::readAmenitiesFromTile(
                             amenitiesToSkip->insert(hash);
                             if(amenitiesOut)
                                 amenitiesOut->push_back(amenity);
+                            acceptedCount++;
+                            accepted = true;
                         }
                     }
+                    if(!accepted && statistics)
+                        statistics->objectsDiscarded++;
                     if(zoomToSkip <= zoom)
                     {
                         cis->Skip(cis->BytesUntilLimit());
-                        return;
+                        return acceptedCount;
                     }
                 }
                 else
@@ -483,6 +522,10 @@ void OsmAnd::ObfPoiSectionReader_P::readAmenitiesFromTile(
                     const auto visitorAgrees = visitor ? visitor(amenity) : true;
                     if(amenitiesOut && visitorAgrees)
                         amenitiesOut->push_back(amenity);
+                    if(visitorAgrees)
+                        acceptedCount++;
+                    else if(statistics)
+                        statistics->objectsDiscarded++;
                 }
             }
             break;
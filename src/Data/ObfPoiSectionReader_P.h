@@ -29,6 +29,7 @@
 
 #include <OsmAndCore.h>
 #include <OsmAndCore/CommonTypes.h>
+#include <OsmAndCore/QueryStatistics.h>
 
 namespace OsmAnd {
 
@@ -81,13 +82,14 @@ namespace OsmAnd {
             QSet< uint64_t >* tilesToSkip);
         static bool checkTileCategories(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfPoiSectionInfo>& section,
             QSet<uint32_t>* desiredCategories);
-        static void readAmenitiesFromTile(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfPoiSectionInfo>& section, Tile* tile,
+        static unsigned int readAmenitiesFromTile(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfPoiSectionInfo>& section, Tile* tile,
             QSet<uint32_t>* desiredCategories,
             QList< std::shared_ptr<const Model::Amenity> >* amenitiesOut,
             const ZoomLevel& zoom, uint32_t zoomDepth, const AreaI* bbox31,
             std::function<bool (const std::shared_ptr<const Model::Amenity>&)> visitor,
             IQueryController* controller,
-            QSet< uint64_t >* amenitiesToSkip);
+            QSet< uint64_t >* amenitiesToSkip,
+            QueryStatistics::Counters* statistics);
         static void readAmenity(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfPoiSectionInfo>& section,
             const PointI& pTile, uint32_t pzoom, std::shared_ptr<Model::Amenity>& amenity,
             QSet<uint32_t>* desiredCategories,
@@ -4,7 +4,6 @@
 #include "ObfFile.h"
 #include "ObfFile_P.h"
 
-#include "QZeroCopyInputStream.h"
 
 OsmAnd::ObfReader::ObfReader( const std::shared_ptr<const ObfFile>& obfFile_ )
     : _d(new ObfReader_P(this))
@@ -24,30 +23,21 @@ OsmAnd::ObfReader::~ObfReader()
 
 std::shared_ptr<OsmAnd::ObfInfo> OsmAnd::ObfReader::obtainInfo() const
 {
+    QMutexLocker scopedLock_reader(&_d->_mutex);
+
     // Check if information is already available
     if(_d->_obfInfo)
         return _d->_obfInfo;
 
-    // Open file for reading (if needed)
-    if(!_d->_codedInputStream)
-    {
-        if(obfFile)
-        {
-            std::shared_ptr<QIODevice> input(new QFile(obfFile->fileInfo.absoluteFilePath()));
-            _d->_input = input;
-        }
-
-        gpb::io::CodedInputStream* cis = new gpb::io::CodedInputStream(new QZeroCopyInputStream(_d->_input));
-        cis->SetTotalBytesLimit(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-        _d->_codedInputStream.reset(cis);
-    }
-
     if(obfFile)
     {
         QMutexLocker scopedLock(&obfFile->_d->_obfInfoMutex);
 
+        // Information may be already known (e.g. from collection index), so file is not even opened
         if(!obfFile->_d->_obfInfo)
         {
+            _d->openInput();
+
             std::shared_ptr<ObfInfo> obfInfo(new ObfInfo());
             ObfReader_P::readInfo(_d, obfInfo);
             obfFile->_d->_obfInfo = obfInfo;
@@ -58,6 +48,8 @@ std::shared_ptr<OsmAnd::ObfInfo> OsmAnd::ObfReader::obtainInfo() const
     }
     else
     {
+        _d->openInput();
+
         std::shared_ptr<ObfInfo> obfInfo(new ObfInfo());
         ObfReader_P::readInfo(_d, obfInfo);
         _d->_obfInfo = obfInfo;
@@ -1,11 +1,19 @@
 #include "ObfReaderUtilities.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <QtEndian>
 
 #include <google/protobuf/wire_format_lite.h>
 
 #include "OBF.pb.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define OSMAND_OBF_READER_UTILITIES_SSE2 1
+#   include <emmintrin.h>
+#endif
+
 bool OsmAnd::ObfReaderUtilities::readQString( gpb::io::CodedInputStream* cis, QString& output )
 {
     std::string value;
@@ -77,29 +85,200 @@ void OsmAnd::ObfReaderUtilities::skipUnknownField( gpb::io::CodedInputStream* ci
         gpb::internal::WireFormatLite::SkipField(cis, tag);
 }
 
-QString OsmAnd::ObfReaderUtilities::encodeIntegerToString( const uint32_t& value )
-{
-    QString fakeQString(2, QChar(QChar::Null));
-    fakeQString.data()[0].unicode() = static_cast<ushort>((value >> 16*0) & 0xffff);
-    fakeQString.data()[1].unicode() = static_cast<ushort>((value >> 16*1) & 0xffff);
+namespace OsmAnd {
+    namespace ObfReaderUtilities_Internal {
+        namespace gpb = google::protobuf;
+
+        inline bool readRawVarint32(const uint8_t*& ptr, const uint8_t* const end, uint32_t& value)
+        {
+            value = 0;
+            for(int shift = 0; ptr != end; shift += 7)
+            {
+                const uint32_t byte = *(ptr++);
+                if(shift < 32)
+                    value |= (byte & 0x7F) << shift;
+                if((byte & 0x80) == 0)
+                    return true;
+                // Varint can not be longer than 10 bytes
+                if(shift >= 63)
+                    return false;
+            }
+            return false;
+        }
+
+        inline uint32_t zigZagDecode32(const uint32_t value)
+        {
+            return (value >> 1) ^ static_cast<uint32_t>(-static_cast<int32_t>(value & 1));
+        }
+
+        struct CoordinatesAccumulator
+        {
+            uint32_t x;
+            uint32_t y;
+            const int shift;
+            PointI* output;
+            AreaI& bbox31;
+
+            inline void append(const uint32_t zx, const uint32_t zy)
+            {
+                // Unsigned arithmetic, since deltas wrap around exactly like original encoder did
+                x += zigZagDecode32(zx);
+                y += zigZagDecode32(zy);
+
+                PointI p;
+                p.x = static_cast<int32_t>(x << shift);
+                p.y = static_cast<int32_t>(y << shift);
+                *(output++) = p;
+
+                bbox31.top = std::min(bbox31.top, p.y);
+                bbox31.left = std::min(bbox31.left, p.x);
+                bbox31.bottom = std::max(bbox31.bottom, p.y);
+                bbox31.right = std::max(bbox31.right, p.x);
+            }
+        };
+
+        // Decodes pairs of varints from raw buffer. Returns pointer past last decoded pair
+        inline const uint8_t* decodeCoordinates(const uint8_t* ptr, const uint8_t* const end, CoordinatesAccumulator& accumulator)
+        {
+            while(ptr != end)
+            {
+#if defined(OSMAND_OBF_READER_UTILITIES_SSE2)
+                // Most deltas fit in single byte, so check 16 bytes at once: if none of them has
+                // continuation bit set, these are exactly 8 points that need no varint parsing
+                while(end - ptr >= 16)
+                {
+                    const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+                    if(_mm_movemask_epi8(bytes) != 0)
+                        break;
+
+                    for(int idx = 0; idx < 16; idx += 2)
+                        accumulator.append(ptr[idx], ptr[idx + 1]);
+                    ptr += 16;
+                }
+                if(ptr == end)
+                    break;
+#endif // OSMAND_OBF_READER_UTILITIES_SSE2
 
-    assert(decodeIntegerFromString(fakeQString) == value);
+                // Fast path for single-byte pair without continuation bits
+                if(end - ptr >= 2 && ((ptr[0] | ptr[1]) & 0x80) == 0)
+                {
+                    accumulator.append(ptr[0], ptr[1]);
+                    ptr += 2;
+                    continue;
+                }
 
-    return fakeQString;
+                auto pairStart = ptr;
+                uint32_t zx;
+                uint32_t zy;
+                if(!readRawVarint32(ptr, end, zx) || !readRawVarint32(ptr, end, zy))
+                    return pairStart;
+                accumulator.append(zx, zy);
+            }
+            return ptr;
+        }
+
+        template<typename CONTAINER>
+        void readCoordinates(gpb::io::CodedInputStream* cis, const PointI& base31, const int shift,
+            CONTAINER& points31, AreaI& bbox31)
+        {
+            const auto bytesToRead = cis->BytesUntilLimit();
+            if(bytesToRead <= 0)
+                return;
+
+            // Each point takes at least 2 bytes, so reserve upper bound once
+            const auto oldSize = points31.size();
+            points31.resize(oldSize + bytesToRead / 2);
+            CoordinatesAccumulator accumulator = {
+                static_cast<uint32_t>(base31.x) >> shift,
+                static_cast<uint32_t>(base31.y) >> shift,
+                shift,
+                points31.data() + oldSize,
+                bbox31
+            };
+            const auto outputStart = accumulator.output;
+
+            const void* data = nullptr;
+            int size = 0;
+            if(cis->GetDirectBufferPointer(&data, &size) && size >= bytesToRead)
+            {
+                // Entire coordinates block is available in buffer (always true for memory-mapped files)
+                const auto begin = reinterpret_cast<const uint8_t*>(data);
+                const auto end = begin + bytesToRead;
+                decodeCoordinates(begin, end, accumulator);
+                cis->Skip(bytesToRead);
+            }
+            else
+            {
+                while(cis->BytesUntilLimit() > 0)
+                {
+                    gpb::uint32 zx;
+                    gpb::uint32 zy;
+                    if(!cis->ReadVarint32(&zx) || !cis->ReadVarint32(&zy))
+                        break;
+                    accumulator.append(zx, zy);
+                }
+            }
+
+            points31.resize(oldSize + (accumulator.output - outputStart));
+        }
+    } // namespace ObfReaderUtilities_Internal
+} // namespace OsmAnd
+using namespace OsmAnd::ObfReaderUtilities_Internal;
+
+void OsmAnd::ObfReaderUtilities::readCoordinates( gpb::io::CodedInputStream* cis, const PointI& base31, const int shift,
+    std::vector<PointI>& points31, AreaI& bbox31 )
+{
+    ObfReaderUtilities_Internal::readCoordinates(cis, base31, shift, points31, bbox31);
 }
 
-uint32_t OsmAnd::ObfReaderUtilities::decodeIntegerFromString( const QString& container )
+void OsmAnd::ObfReaderUtilities::readCoordinates( gpb::io::CodedInputStream* cis, const PointI& base31, const int shift,
+    QVector<PointI>& points31, AreaI& bbox31 )
 {
-    uint32_t res = 0;
+    ObfReaderUtilities_Internal::readCoordinates(cis, base31, shift, points31, bbox31);
+}
 
-    ushort value;
+bool OsmAnd::ObfReaderUtilities::mayCoordinatesIntersect( gpb::io::CodedInputStream* cis, const PointI& base31, const int shift, const AreaI& area31 )
+{
+    const auto bytesToRead = cis->BytesUntilLimit();
+    if(bytesToRead <= 0)
+        return true;
 
-    value = container.at(0).unicode();
-    res |= (value & 0xffff) << 16*0;
+    // Without raw buffer stream can't be scanned without consuming it, so nothing is proven
+    const void* data = nullptr;
+    int size = 0;
+    if(!cis->GetDirectBufferPointer(&data, &size) || size < bytesToRead)
+        return true;
 
-    value = container.at(1).unicode();
-    res |= (value & 0xffff) << 16*1;
+    auto x = static_cast<uint32_t>(base31.x) >> shift;
+    auto y = static_cast<uint32_t>(base31.y) >> shift;
+    AreaI bbox31;
+    bbox31.top = bbox31.left = std::numeric_limits<int32_t>::max();
+    bbox31.bottom = bbox31.right = 0;
+    auto ptr = reinterpret_cast<const uint8_t*>(data);
+    const auto end = ptr + bytesToRead;
+    auto hasPoints = false;
+    while(ptr != end)
+    {
+        uint32_t zx;
+        uint32_t zy;
+        if(!readRawVarint32(ptr, end, zx) || !readRawVarint32(ptr, end, zy))
+            break;
+        x += zigZagDecode32(zx);
+        y += zigZagDecode32(zy);
+        hasPoints = true;
 
-    return res;
-}
+        const auto px = static_cast<int32_t>(x << shift);
+        const auto py = static_cast<int32_t>(y << shift);
+        bbox31.top = std::min(bbox31.top, py);
+        bbox31.left = std::min(bbox31.left, px);
+        bbox31.bottom = std::max(bbox31.bottom, py);
+        bbox31.right = std::max(bbox31.right, px);
 
+        // Bbox only grows, so once it intersects area, it will intersect it till the end
+        if(area31.intersects(bbox31))
+            return true;
+    }
+
+    // Object without points is treated as inside, same as when it's decoded
+    return !hasPoints;
+}
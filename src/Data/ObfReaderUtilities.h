@@ -23,13 +23,16 @@
 #define __OBF_READER_UTILITIES_H_
 
 #include <cstdint>
+#include <vector>
 
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 #include <google/protobuf/io/coded_stream.h>
 
 #include <OsmAndCore.h>
+#include <CommonTypes.h>
 
 namespace OsmAnd {
 
@@ -43,8 +46,18 @@ namespace OsmAnd {
         uint32_t readBigEndianInt(gpb::io::CodedInputStream* cis);
         void readStringTable(gpb::io::CodedInputStream* cis, QStringList& stringTableOut);
         void skipUnknownField(gpb::io::CodedInputStream* cis, int tag);
-        QString encodeIntegerToString(const uint32_t& value);
-        uint32_t decodeIntegerFromString(const QString& container);
+
+        // Decodes all zigzag-encoded coordinate deltas up to current limit in one pass.
+        // Deltas are accumulated starting from (base31 >> shift), and each point is stored shifted back by 'shift'.
+        // Decoded points are appended to 'points31', and 'bbox31' is enlarged to include them.
+        void readCoordinates(gpb::io::CodedInputStream* cis, const PointI& base31, const int shift,
+            std::vector<PointI>& points31, AreaI& bbox31);
+        void readCoordinates(gpb::io::CodedInputStream* cis, const PointI& base31, const int shift,
+            QVector<PointI>& points31, AreaI& bbox31);
+        // Scans coordinates up to current limit without consuming them, tracking only their running bbox.
+        // Stops and returns true as soon as that bbox intersects area31. Returns false only if all points
+        // were scanned and none of them made bbox intersect area31
+        bool mayCoordinatesIntersect(gpb::io::CodedInputStream* cis, const PointI& base31, const int shift, const AreaI& area31);
 
     } // namespace ObfReaderUtilities
     
@@ -1,5 +1,10 @@
 #include "ObfReader_P.h"
+#include "ObfReader.h"
 
+#include <QDataStream>
+
+#include "ObfFile.h"
+#include "ObfFile_P.h"
 #include "ObfInfo.h"
 #include "ObfMapSectionInfo.h"
 #include "ObfMapSectionReader_P.h"
@@ -8,16 +13,19 @@
 #include "ObfTransportSectionInfo.h"
 #include "ObfTransportSectionReader_P.h"
 #include "ObfRoutingSectionInfo.h"
+#include "ObfRoutingSectionInfo_P.h"
 #include "ObfRoutingSectionReader_P.h"
 #include "ObfPoiSectionInfo.h"
 #include "ObfPoiSectionReader_P.h"
 #include "ObfReaderUtilities.h"
+#include "QZeroCopyInputStream.h"
 
 #include "OBF.pb.h"
 #include <google/protobuf/wire_format_lite.h>
 
 OsmAnd::ObfReader_P::ObfReader_P( ObfReader* owner_ )
     : owner(owner_)
+    , _mutex(QMutex::Recursive)
 {
 }
 
@@ -30,6 +38,47 @@ QString OsmAnd::ObfReader_P::transliterate( const QString& input )
     return QString("!transliterate!");
 }
 
+void OsmAnd::ObfReader_P::openInput()
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    if(_codedInputStream)
+        return;
+
+    // Local files are memory-mapped, unless mapping fails. Mapping of ObfFile is shared
+    // between all readers of that file.
+    const auto& obfFile = owner->obfFile;
+    std::shared_ptr<const QMemoryMappedZeroCopyInputStream::Mapping> mapping;
+    if(obfFile)
+        mapping = obfFile->_d->obtainMapping();
+    else if(const auto file = std::dynamic_pointer_cast<QFile>(_input))
+        mapping.reset(new QMemoryMappedZeroCopyInputStream::Mapping(file));
+
+    if(mapping && mapping->isMapped())
+    {
+        _mapping = mapping;
+        _zeroCopyInputStream.reset(new QMemoryMappedZeroCopyInputStream(mapping));
+    }
+    else
+    {
+        if(obfFile)
+        {
+            std::shared_ptr<QIODevice> input(new QFile(obfFile->fileInfo.absoluteFilePath()));
+            _input = input;
+        }
+        _zeroCopyInputStream.reset(new QZeroCopyInputStream(_input));
+    }
+
+    _codedInputStream.reset(createCodedInputStream(_zeroCopyInputStream.get()));
+}
+
+gpb::io::CodedInputStream* OsmAnd::ObfReader_P::createCodedInputStream( gpb::io::ZeroCopyInputStream* input )
+{
+    auto cis = new gpb::io::CodedInputStream(input);
+    cis->SetTotalBytesLimit(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+    return cis;
+}
+
 void OsmAnd::ObfReader_P::readInfo( const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<ObfInfo>& info )
 {
     auto cis = reader->_codedInputStream.get();
@@ -126,3 +175,281 @@ void OsmAnd::ObfReader_P::readInfo( const std::unique_ptr<ObfReader_P>& reader,
         }
     }
 }
+
+OsmAnd::ObfReader_P::Cursor::Cursor( const std::unique_ptr<ObfReader_P>& owner )
+    : _owner(owner)
+    , _lockedMutex(nullptr)
+{
+    // Ensure that reader is opened
+    _owner->owner->obtainInfo();
+    _owner->openInput();
+
+    if(_owner->_mapping)
+    {
+        // Cursor shares mapping with reader, but has it's own position
+        _cursor.reset(new ObfReader_P(_owner->owner));
+        _cursor->_obfInfo = _owner->_obfInfo;
+        _cursor->_mapping = _owner->_mapping;
+        _cursor->_zeroCopyInputStream.reset(new QMemoryMappedZeroCopyInputStream(_owner->_mapping));
+        _cursor->_codedInputStream.reset(createCodedInputStream(_cursor->_zeroCopyInputStream.get()));
+    }
+    else
+    {
+        // Reader's own stream can serve only one query at a time
+        _lockedMutex = &_owner->_mutex;
+        _lockedMutex->lock();
+    }
+}
+
+OsmAnd::ObfReader_P::Cursor::~Cursor()
+{
+    if(_lockedMutex)
+        _lockedMutex->unlock();
+}
+
+const std::unique_ptr<OsmAnd::ObfReader_P>& OsmAnd::ObfReader_P::Cursor::reader() const
+{
+    return _cursor ? _cursor : _owner;
+}
+
+void OsmAnd::ObfReader_P::serializeInfo( QDataStream& stream, const std::shared_ptr<const ObfInfo>& info )
+{
+    stream << static_cast<qint32>(info->_version);
+    stream << static_cast<quint64>(info->_creationTimestamp);
+    stream << info->_isBasemap;
+
+    stream << static_cast<quint32>(info->_mapSections.size());
+    for(auto itSection = info->_mapSections.cbegin(); itSection != info->_mapSections.cend(); ++itSection)
+    {
+        const auto& section = *itSection;
+
+        serializeSectionInfo(stream, section);
+        stream << section->_isBasemap;
+        stream << static_cast<quint32>(section->_levels.size());
+        for(auto itLevel = section->_levels.cbegin(); itLevel != section->_levels.cend(); ++itLevel)
+        {
+            const auto& level = *itLevel;
+
+            stream << level->_offset << level->_length;
+            stream << static_cast<qint32>(level->_minZoom) << static_cast<qint32>(level->_maxZoom);
+            stream << level->_area31.left << level->_area31.top << level->_area31.right << level->_area31.bottom;
+            stream << level->_boxesInnerOffset;
+        }
+    }
+
+    stream << static_cast<quint32>(info->_addressSections.size());
+    for(auto itSection = info->_addressSections.cbegin(); itSection != info->_addressSections.cend(); ++itSection)
+    {
+        const auto& section = *itSection;
+
+        serializeSectionInfo(stream, section);
+        stream << section->_latinName;
+        stream << static_cast<quint32>(section->_addressBlocksSections.size());
+        for(auto itBlocksSection = section->_addressBlocksSections.cbegin(); itBlocksSection != section->_addressBlocksSections.cend(); ++itBlocksSection)
+        {
+            const auto& blocksSection = *itBlocksSection;
+
+            serializeSectionInfo(stream, blocksSection);
+            stream << static_cast<qint32>(blocksSection->_type);
+        }
+    }
+
+    stream << static_cast<quint32>(info->_routingSections.size());
+    for(auto itSection = info->_routingSections.cbegin(); itSection != info->_routingSections.cend(); ++itSection)
+    {
+        const auto& section = *itSection;
+
+        serializeSectionInfo(stream, section);
+        const auto& encodingRules = section->_d->_encodingRules;
+        stream << static_cast<quint32>(encodingRules.size());
+        for(auto itEncodingRule = encodingRules.cbegin(); itEncodingRule != encodingRules.cend(); ++itEncodingRule)
+        {
+            const auto& encodingRule = *itEncodingRule;
+
+            // Rules list has gaps, if rule identifiers are not sequential
+            stream << static_cast<bool>(encodingRule);
+            if(!encodingRule)
+                continue;
+            stream << encodingRule->_id << encodingRule->_tag << encodingRule->_value;
+            stream << static_cast<quint32>(encodingRule->_type) << encodingRule->_parsedValue.asUnsignedInt;
+        }
+        serializeRoutingSubsections(stream, section->_subsections);
+        serializeRoutingSubsections(stream, section->_baseSubsections);
+        stream << section->_d->_borderBoxOffset << section->_d->_borderBoxLength;
+        stream << section->_d->_baseBorderBoxOffset << section->_d->_baseBorderBoxLength;
+    }
+
+    stream << static_cast<quint32>(info->_poiSections.size());
+    for(auto itSection = info->_poiSections.cbegin(); itSection != info->_poiSections.cend(); ++itSection)
+    {
+        const auto& section = *itSection;
+
+        serializeSectionInfo(stream, section);
+        stream << section->_area31.left << section->_area31.top << section->_area31.right << section->_area31.bottom;
+    }
+
+    stream << static_cast<quint32>(info->_transportSections.size());
+    for(auto itSection = info->_transportSections.cbegin(); itSection != info->_transportSections.cend(); ++itSection)
+    {
+        const auto& section = *itSection;
+
+        serializeSectionInfo(stream, section);
+        stream << section->_area24.left << section->_area24.top << section->_area24.right << section->_area24.bottom;
+        stream << section->_stopsOffset << section->_stopsLength;
+    }
+}
+
+std::shared_ptr<OsmAnd::ObfInfo> OsmAnd::ObfReader_P::deserializeInfo( QDataStream& stream )
+{
+    std::shared_ptr<ObfInfo> info(new ObfInfo());
+    quint32 count;
+
+    qint32 version;
+    quint64 creationTimestamp;
+    stream >> version >> creationTimestamp >> info->_isBasemap;
+    info->_version = version;
+    info->_creationTimestamp = creationTimestamp;
+
+    stream >> count;
+    for(auto idx = 0u; idx < count && stream.status() == QDataStream::Ok; idx++)
+    {
+        std::shared_ptr<ObfMapSectionInfo> section(new ObfMapSectionInfo(info));
+        deserializeSectionInfo(stream, section);
+        stream >> section->_isBasemap;
+
+        quint32 levelsCount;
+        stream >> levelsCount;
+        for(auto levelIdx = 0u; levelIdx < levelsCount && stream.status() == QDataStream::Ok; levelIdx++)
+        {
+            std::shared_ptr<ObfMapSectionLevel> level(new ObfMapSectionLevel());
+            qint32 minZoom;
+            qint32 maxZoom;
+            stream >> level->_offset >> level->_length;
+            stream >> minZoom >> maxZoom;
+            stream >> level->_area31.left >> level->_area31.top >> level->_area31.right >> level->_area31.bottom;
+            stream >> level->_boxesInnerOffset;
+            level->_minZoom = static_cast<ZoomLevel>(minZoom);
+            level->_maxZoom = static_cast<ZoomLevel>(maxZoom);
+            section->_levels.push_back(level);
+        }
+        info->_mapSections.push_back(section);
+    }
+
+    stream >> count;
+    for(auto idx = 0u; idx < count && stream.status() == QDataStream::Ok; idx++)
+    {
+        std::shared_ptr<ObfAddressSectionInfo> section(new ObfAddressSectionInfo(info));
+        deserializeSectionInfo(stream, section);
+        stream >> section->_latinName;
+
+        quint32 blocksSectionsCount;
+        stream >> blocksSectionsCount;
+        for(auto blocksSectionIdx = 0u; blocksSectionIdx < blocksSectionsCount && stream.status() == QDataStream::Ok; blocksSectionIdx++)
+        {
+            std::shared_ptr<ObfAddressBlocksSectionInfo> blocksSection(new ObfAddressBlocksSectionInfo(section, info));
+            deserializeSectionInfo(stream, blocksSection);
+            qint32 type;
+            stream >> type;
+            blocksSection->_type = static_cast<ObfAddressBlockType>(type);
+            section->_addressBlocksSections.push_back(blocksSection);
+        }
+        info->_addressSections.push_back(section);
+    }
+
+    stream >> count;
+    for(auto idx = 0u; idx < count && stream.status() == QDataStream::Ok; idx++)
+    {
+        std::shared_ptr<ObfRoutingSectionInfo> section(new ObfRoutingSectionInfo(info));
+        deserializeSectionInfo(stream, section);
+
+        quint32 encodingRulesCount;
+        stream >> encodingRulesCount;
+        for(auto ruleIdx = 0u; ruleIdx < encodingRulesCount && stream.status() == QDataStream::Ok; ruleIdx++)
+        {
+            bool present;
+            stream >> present;
+            if(!present)
+            {
+                section->_d->_encodingRules.push_back(std::shared_ptr<ObfRoutingSectionInfo_P::EncodingRule>());
+                continue;
+            }
+
+            std::shared_ptr<ObfRoutingSectionInfo_P::EncodingRule> encodingRule(new ObfRoutingSectionInfo_P::EncodingRule());
+            quint32 type;
+            stream >> encodingRule->_id >> encodingRule->_tag >> encodingRule->_value;
+            stream >> type >> encodingRule->_parsedValue.asUnsignedInt;
+            encodingRule->_type = static_cast<ObfRoutingSectionInfo_P::EncodingRule::Type>(type);
+            section->_d->_encodingRules.push_back(encodingRule);
+        }
+        deserializeRoutingSubsections(stream, section->_subsections, section, nullptr);
+        deserializeRoutingSubsections(stream, section->_baseSubsections, section, nullptr);
+        stream >> section->_d->_borderBoxOffset >> section->_d->_borderBoxLength;
+        stream >> section->_d->_baseBorderBoxOffset >> section->_d->_baseBorderBoxLength;
+        info->_routingSections.push_back(section);
+    }
+
+    stream >> count;
+    for(auto idx = 0u; idx < count && stream.status() == QDataStream::Ok; idx++)
+    {
+        std::shared_ptr<ObfPoiSectionInfo> section(new ObfPoiSectionInfo(info));
+        deserializeSectionInfo(stream, section);
+        stream >> section->_area31.left >> section->_area31.top >> section->_area31.right >> section->_area31.bottom;
+        info->_poiSections.push_back(section);
+    }
+
+    stream >> count;
+    for(auto idx = 0u; idx < count && stream.status() == QDataStream::Ok; idx++)
+    {
+        std::shared_ptr<ObfTransportSectionInfo> section(new ObfTransportSectionInfo(info));
+        deserializeSectionInfo(stream, section);
+        stream >> section->_area24.left >> section->_area24.top >> section->_area24.right >> section->_area24.bottom;
+        stream >> section->_stopsOffset >> section->_stopsLength;
+        info->_transportSections.push_back(section);
+    }
+
+    // Truncated or damaged data is not usable at all
+    if(stream.status() != QDataStream::Ok)
+        return nullptr;
+
+    return info;
+}
+
+void OsmAnd::ObfReader_P::serializeSectionInfo( QDataStream& stream, const std::shared_ptr<const ObfSectionInfo>& section )
+{
+    stream << section->_name << section->_offset << section->_length;
+}
+
+void OsmAnd::ObfReader_P::deserializeSectionInfo( QDataStream& stream, const std::shared_ptr<ObfSectionInfo>& section )
+{
+    stream >> section->_name >> section->_offset >> section->_length;
+}
+
+void OsmAnd::ObfReader_P::serializeRoutingSubsections( QDataStream& stream, const QList< std::shared_ptr<ObfRoutingSubsectionInfo> >& subsections )
+{
+    stream << static_cast<quint32>(subsections.size());
+    for(auto itSubsection = subsections.cbegin(); itSubsection != subsections.cend(); ++itSubsection)
+    {
+        const auto& subsection = *itSubsection;
+
+        serializeSectionInfo(stream, subsection);
+        stream << subsection->_area31.left << subsection->_area31.top << subsection->_area31.right << subsection->_area31.bottom;
+        stream << subsection->_dataOffset << subsection->_subsectionsOffset;
+        serializeRoutingSubsections(stream, subsection->_subsections);
+    }
+}
+
+void OsmAnd::ObfReader_P::deserializeRoutingSubsections( QDataStream& stream, QList< std::shared_ptr<ObfRoutingSubsectionInfo> >& subsections,
+    const std::shared_ptr<ObfRoutingSectionInfo>& section, const std::shared_ptr<ObfRoutingSubsectionInfo>& parent )
+{
+    quint32 count;
+    stream >> count;
+    for(auto idx = 0u; idx < count && stream.status() == QDataStream::Ok; idx++)
+    {
+        std::shared_ptr<ObfRoutingSubsectionInfo> subsection(parent ? new ObfRoutingSubsectionInfo(parent) : new ObfRoutingSubsectionInfo(section));
+        deserializeSectionInfo(stream, subsection);
+        stream >> subsection->_area31.left >> subsection->_area31.top >> subsection->_area31.right >> subsection->_area31.bottom;
+        stream >> subsection->_dataOffset >> subsection->_subsectionsOffset;
+        deserializeRoutingSubsections(stream, subsection->_subsections, section, subsection);
+        subsections.push_back(subsection);
+    }
+}
@@ -28,19 +28,27 @@
 #include <functional>
 
 #include <QString>
+#include <QMutex>
 
+#include <google/protobuf/io/zero_copy_stream.h>
 #include <google/protobuf/io/coded_stream.h>
 
 #include <OsmAndCore.h>
 #include <OsmAndCore/IQueryController.h>
+#include <OsmAndCore/QMemoryMappedZeroCopyInputStream.h>
 
 class QIODevice;
+class QDataStream;
 
 namespace OsmAnd {
 
     namespace gpb = google::protobuf;
 
     class ObfInfo;
+    class ObfSectionInfo;
+    class ObfRoutingSectionInfo;
+    class ObfRoutingSubsectionInfo;
+    class ObfsCollection_P;
 
     class ObfMapSectionReader_P;
     class ObfAddressSectionReader_P;
@@ -56,6 +64,10 @@ namespace OsmAnd {
         ObfReader_P(ObfReader* owner);
 
         ObfReader* const owner;
+
+        QMutex _mutex;
+        std::shared_ptr<const QMemoryMappedZeroCopyInputStream::Mapping> _mapping;
+        std::shared_ptr<gpb::io::ZeroCopyInputStream> _zeroCopyInputStream;
         std::shared_ptr<gpb::io::CodedInputStream> _codedInputStream;
 
         std::shared_ptr<QIODevice> _input;
@@ -63,11 +75,45 @@ namespace OsmAnd {
 
         QString transliterate(const QString& input);
 
+        void openInput();
+
         static void readInfo(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<ObfInfo>& info);
+        static gpb::io::CodedInputStream* createCodedInputStream(gpb::io::ZeroCopyInputStream* input);
+
+        // Serialized ObfInfo is used to avoid parsing OBF file headers on each start
+        enum {
+            SerializedInfoVersion = 1,
+        };
+        static void serializeInfo(QDataStream& stream, const std::shared_ptr<const ObfInfo>& info);
+        static std::shared_ptr<ObfInfo> deserializeInfo(QDataStream& stream);
+        static void serializeSectionInfo(QDataStream& stream, const std::shared_ptr<const ObfSectionInfo>& section);
+        static void deserializeSectionInfo(QDataStream& stream, const std::shared_ptr<ObfSectionInfo>& section);
+        static void serializeRoutingSubsections(QDataStream& stream, const QList< std::shared_ptr<ObfRoutingSubsectionInfo> >& subsections);
+        static void deserializeRoutingSubsections(QDataStream& stream, QList< std::shared_ptr<ObfRoutingSubsectionInfo> >& subsections,
+            const std::shared_ptr<ObfRoutingSectionInfo>& section, const std::shared_ptr<ObfRoutingSubsectionInfo>& parent);
+
+        // Gives access to reader for duration of a single query. If file is memory-mapped,
+        // query gets it's own cursor over shared mapping, so any number of queries can run
+        // concurrently. Otherwise reader itself is locked until query is finished.
+        class Cursor
+        {
+            Q_DISABLE_COPY(Cursor)
+        private:
+            const std::unique_ptr<ObfReader_P>& _owner;
+            std::unique_ptr<ObfReader_P> _cursor;
+            QMutex* _lockedMutex;
+        protected:
+        public:
+            Cursor(const std::unique_ptr<ObfReader_P>& owner);
+            ~Cursor();
+
+            const std::unique_ptr<ObfReader_P>& reader() const;
+        };
     public:
         virtual ~ObfReader_P();
 
     friend class OsmAnd::ObfReader;
+    friend class OsmAnd::ObfsCollection_P;
 
     friend class OsmAnd::ObfMapSectionReader_P;
     friend class OsmAnd::ObfAddressSectionReader_P;
@@ -4,6 +4,10 @@
 
 OsmAnd::ObfRoutingSectionInfo_P::ObfRoutingSectionInfo_P( ObfRoutingSectionInfo* owner_ )
     : owner(owner_)
+    , _borderBoxOffset(0)
+    , _baseBorderBoxOffset(0)
+    , _borderBoxLength(0)
+    , _baseBorderBoxLength(0)
 {
 }
 
@@ -27,6 +27,7 @@
 #include <memory>
 
 #include <QList>
+#include <QMutex>
 
 #include <OsmAndCore.h>
 #include <OsmAndCore/CommonTypes.h>
@@ -34,6 +35,7 @@
 namespace OsmAnd {
 
     class ObfRoutingSectionReader_P;
+    class ObfReader_P;
     namespace Model {
         STRONG_ENUM_EX(RoadDirection, int32_t);
         class Road;
@@ -82,6 +84,8 @@ namespace OsmAnd {
         };
         QList< std::shared_ptr<EncodingRule> > _encodingRules;
 
+        QMutex _subsectionsLoadMutex;
+
         uint32_t _borderBoxOffset;
         uint32_t _baseBorderBoxOffset;
         uint32_t _borderBoxLength;
@@ -91,6 +95,7 @@ namespace OsmAnd {
 
     friend class OsmAnd::ObfRoutingSectionInfo;
     friend class OsmAnd::ObfRoutingSectionReader_P;
+    friend class OsmAnd::ObfReader_P;
     friend class OsmAnd::Model::Road;
     friend class OsmAnd::RoutePlanner;
     friend class OsmAnd::RoutePlannerContext;
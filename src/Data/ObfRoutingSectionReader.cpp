@@ -2,6 +2,8 @@
 #include "ObfRoutingSectionReader_P.h"
 
 #include "ObfReader.h"
+#include "ObfReader_P.h"
+#include "ObfRoutingSubsectionsDataCache.h"
 
 OsmAnd::ObfRoutingSectionReader::ObfRoutingSectionReader()
 {
@@ -16,15 +18,18 @@ void OsmAnd::ObfRoutingSectionReader::querySubsections(
     QList< std::shared_ptr<const ObfRoutingSubsectionInfo> >* resultOut /*= nullptr*/, IQueryFilter* filter /*= nullptr*/,
     std::function<bool (const std::shared_ptr<const ObfRoutingSubsectionInfo>&)> visitor /*= nullptr*/ )
 {
-    ObfRoutingSectionReader_P::querySubsections(reader->_d, in, resultOut, filter, visitor);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfRoutingSectionReader_P::querySubsections(cursor.reader(), in, resultOut, filter, visitor);
 }
 
 void OsmAnd::ObfRoutingSectionReader::loadSubsectionData(
     const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection,
     QList< std::shared_ptr<const Model::Road> >* resultOut /*= nullptr*/, QMap< uint64_t, std::shared_ptr<const Model::Road> >* resultMapOut /*= nullptr*/,
-    IQueryFilter* filter /*= nullptr*/, std::function<bool (const std::shared_ptr<const OsmAnd::Model::Road>&)> visitor /*= nullptr*/ )
+    IQueryFilter* filter /*= nullptr*/, std::function<bool (const std::shared_ptr<const OsmAnd::Model::Road>&)> visitor /*= nullptr*/,
+    IQueryController* controller /*= nullptr*/ )
 {
-    ObfRoutingSectionReader_P::loadSubsectionData(reader->_d, subsection, resultOut, resultMapOut, filter, visitor);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfRoutingSectionReader_P::loadSubsectionData(cursor.reader(), subsection, resultOut, resultMapOut, filter, visitor, controller);
 }
 
 void OsmAnd::ObfRoutingSectionReader::loadSubsectionBorderBoxLinesPoints(
@@ -33,5 +38,26 @@ void OsmAnd::ObfRoutingSectionReader::loadSubsectionBorderBoxLinesPoints(
     std::function<bool (const std::shared_ptr<const ObfRoutingBorderLineHeader>&)> visitorLine /*= nullptr*/,
     std::function<bool (const std::shared_ptr<const ObfRoutingBorderLinePoint>&)> visitorPoint /*= nullptr*/ )
 {
-    ObfRoutingSectionReader_P::loadSubsectionBorderBoxLinesPoints(reader->_d, section, resultOut, filter, visitorLine);
+    ObfReader_P::Cursor cursor(reader->_d);
+    ObfRoutingSectionReader_P::loadSubsectionBorderBoxLinesPoints(cursor.reader(), section, resultOut, filter, visitorLine);
+}
+
+void OsmAnd::ObfRoutingSectionReader::setSubsectionsDataCacheMemoryLimit( const size_t limitInBytes )
+{
+    ObfRoutingSubsectionsDataCache::instance->setMemoryLimit(limitInBytes);
+}
+
+size_t OsmAnd::ObfRoutingSectionReader::getSubsectionsDataCacheMemoryLimit()
+{
+    return ObfRoutingSubsectionsDataCache::instance->getMemoryLimit();
+}
+
+OsmAnd::ObfRoutingSectionReader::SubsectionsDataCacheMetrics OsmAnd::ObfRoutingSectionReader::getSubsectionsDataCacheMetrics()
+{
+    return ObfRoutingSubsectionsDataCache::instance->getMetrics();
+}
+
+void OsmAnd::ObfRoutingSectionReader::clearSubsectionsDataCache()
+{
+    ObfRoutingSubsectionsDataCache::instance->clear();
 }
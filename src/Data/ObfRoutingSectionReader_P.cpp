@@ -6,7 +6,10 @@
 #include "ObfRoutingSectionInfo_P.h"
 #include "Road.h"
 #include "IQueryFilter.h"
+#include "IQueryController.h"
+#include "QueryStatistics.h"
 #include "ObfReaderUtilities.h"
+#include "ObfStringTable.h"
 #include "Utilities.h"
 
 #include "OBF.pb.h"
@@ -310,14 +313,18 @@ void OsmAnd::ObfRoutingSectionReader_P::querySubsections(
             continue;
         
         // Load children if they are not yet loaded
-        if(subsection->_subsectionsOffset != 0 && subsection->_subsections.isEmpty())
         {
-            cis->Seek(subsection->_offset);
-            auto oldLimit = cis->PushLimit(subsection->_length);
-            cis->Skip(subsection->_subsectionsOffset - subsection->_offset);
-            const auto contains = !filter || filter->acceptsArea(subsection->_area31);
-            readSubsectionChildrenHeaders(reader, subsection, contains ? std::numeric_limits<uint32_t>::max() : 1);
-            cis->PopLimit(oldLimit);
+            QMutexLocker scopedLock(&subsection->section->_d->_subsectionsLoadMutex);
+
+            if(subsection->_subsectionsOffset != 0 && subsection->_subsections.isEmpty())
+            {
+                cis->Seek(subsection->_offset);
+                auto oldLimit = cis->PushLimit(subsection->_length);
+                cis->Skip(subsection->_subsectionsOffset - subsection->_offset);
+                const auto contains = !filter || filter->acceptsArea(subsection->_area31);
+                readSubsectionChildrenHeaders(reader, subsection, contains ? std::numeric_limits<uint32_t>::max() : 1);
+                cis->PopLimit(oldLimit);
+            }
         }
 
         querySubsections(reader, subsection->_subsections, resultOut, filter, visitor);
@@ -335,32 +342,63 @@ void OsmAnd::ObfRoutingSectionReader_P::loadSubsectionData(
     QList< std::shared_ptr<const Model::Road> >* resultOut /*= nullptr*/,
     QMap< uint64_t, std::shared_ptr<const Model::Road> >* resultMapOut /*= nullptr*/,
     IQueryFilter* filter /*= nullptr*/,
-    std::function<bool (const std::shared_ptr<const Model::Road>&)> visitor /*= nullptr*/ )
+    std::function<bool (const std::shared_ptr<const Model::Road>&)> visitor /*= nullptr*/,
+    IQueryController* controller /*= nullptr*/ )
 {
     auto cis = reader->_codedInputStream.get();
 
+    if(controller && controller->isAborted())
+        return;
+
+    const auto statistics = controller ? controller->getStatistics() : nullptr;
+    const QueryStatistics::Stopwatch blockDecodingStopwatch(statistics != nullptr);
+
     cis->Seek(subsection->_offset + subsection->_dataOffset);
     gpb::uint32 length;
     cis->ReadVarint32(&length);
     auto oldLimit = cis->PushLimit(length);
-    readSubsectionData(reader, subsection, resultOut, resultMapOut, filter, visitor);
+    const auto roadsCount = readSubsectionData(reader, subsection, resultOut, resultMapOut, filter, visitor, controller);
     cis->PopLimit(oldLimit);
+
+    if(statistics)
+    {
+        QueryStatistics::Counters counters;
+        counters.seeksCount = 1;
+        counters.blocksRead = 1;
+        counters.bytesRead = length;
+        counters.blocksDecodingTime = blockDecodingStopwatch.elapsed();
+        statistics->add(counters);
+    }
+
+    if(controller)
+        controller->onBlockProcessed(roadsCount, length);
 }
 
-void OsmAnd::ObfRoutingSectionReader_P::readSubsectionData(
+unsigned int OsmAnd::ObfRoutingSectionReader_P::readSubsectionData(
     const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection,
     QList< std::shared_ptr<const Model::Road> >* resultOut /*= nullptr*/,
     QMap< uint64_t, std::shared_ptr<const Model::Road> >* resultMapOut /*= nullptr*/,
     IQueryFilter* filter /*= nullptr*/,
-    std::function<bool (const std::shared_ptr<const Model::Road>&)> visitor /*= nullptr*/ )
+    std::function<bool (const std::shared_ptr<const Model::Road>&)> visitor /*= nullptr*/,
+    IQueryController* controller /*= nullptr*/ )
 {
-    QStringList roadNamesTable;
+    const std::shared_ptr<ObfStringTable> roadNamesTable(new ObfStringTable());
     QList<uint64_t> roadsIdsTable;
     QMap< uint32_t, std::shared_ptr<Model::Road> > resultsByInternalId;
+    unsigned int acceptedCount = 0;
+    const auto statistics = controller ? controller->getStatistics() : nullptr;
+    QueryStatistics::Counters counters;
 
     auto cis = reader->_codedInputStream.get();
     for(;;)
     {
+        // Roads of block are given out only when entire block was read
+        if(controller && controller->isAborted())
+        {
+            cis->Skip(cis->BytesUntilLimit());
+            return 0;
+        }
+
         auto tag = cis->ReadTag();
         switch(gpb::internal::WireFormatLite::GetTagFieldNumber(tag))
         {
@@ -370,14 +408,16 @@ void OsmAnd::ObfRoutingSectionReader_P::readSubsectionData(
                 {
                     auto road = itEntry.value();
 
-                    // Fill names of roads from stringtable
-                    for(auto itNameEntry = road->_names.begin(); itNameEntry != road->_names.end(); ++itNameEntry)
+                    // Names are decoded from stringtable only on request, empty ones are dropped right away
+                    for(auto itNameId = road->_namesIds.begin(); itNameId != road->_namesIds.end();)
                     {
-                        auto encodedId = itNameEntry.value();
-                        uint32_t stringId = ObfReaderUtilities::decodeIntegerFromString(encodedId);
-
-                        itNameEntry.value() = roadNamesTable[stringId];
+                        if(roadNamesTable->isEmptyString(itNameId.value()))
+                            itNameId = road->_namesIds.erase(itNameId);
+                        else
+                            ++itNameId;
                     }
+                    if(!road->_namesIds.isEmpty())
+                        road->_stringTable = roadNamesTable;
 
                     if(!visitor || visitor(road))
                     {
@@ -385,10 +425,19 @@ void OsmAnd::ObfRoutingSectionReader_P::readSubsectionData(
                             resultOut->push_back(road);
                         if(resultMapOut)
                             resultMapOut->insert(road->_id, road);
+                        acceptedCount++;
                     }
+                    else
+                        counters.objectsDiscarded++;
+                }
+
+                if(statistics)
+                {
+                    counters.objectsDecoded = resultsByInternalId.size();
+                    statistics->add(counters);
                 }
             }
-            return;
+            return acceptedCount;
         case OBF::OsmAndRoutingIndex_RouteDataBlock::kIdTableFieldNumber:
             {
                 gpb::uint32 length;
@@ -424,7 +473,9 @@ void OsmAnd::ObfRoutingSectionReader_P::readSubsectionData(
                 gpb::uint32 length;
                 cis->ReadVarint32(&length);
                 auto oldLimit = cis->PushLimit(length);
-                ObfReaderUtilities::readStringTable(cis, roadNamesTable);
+                const QueryStatistics::Stopwatch stringTableStopwatch(statistics != nullptr);
+                roadNamesTable->read(cis);
+                counters.stringTablesReadingTime += stringTableStopwatch.elapsed();
                 cis->PopLimit(oldLimit);
             }
             break;
@@ -523,19 +574,9 @@ void OsmAnd::ObfRoutingSectionReader_P::readRoad(
                 gpb::uint32 length;
                 cis->ReadVarint32(&length);
                 auto oldLimit = cis->PushLimit(length);
-                auto dx = subsection->_area31.left >> ShiftCoordinates;
-                auto dy = subsection->_area31.top >> ShiftCoordinates;
-                while(cis->BytesUntilLimit() > 0)
-                {
-                    uint32_t x = ObfReaderUtilities::readSInt32(cis) + dx;
-                    uint32_t y = ObfReaderUtilities::readSInt32(cis) + dy;
-                    road->_points.push_back(PointI(
-                        x << ShiftCoordinates,
-                        y << ShiftCoordinates
-                        ));
-                    dx = x;
-                    dy = y;
-                }
+                const PointI base31(subsection->_area31.left, subsection->_area31.top);
+                AreaI roadBBox;
+                ObfReaderUtilities::readCoordinates(cis, base31, ShiftCoordinates, road->_points, roadBBox);
                 cis->PopLimit(oldLimit);
             }
             break;
@@ -602,7 +643,7 @@ void OsmAnd::ObfRoutingSectionReader_P::readRoad(
                     gpb::uint32 stringId;
                     cis->ReadVarint32(&stringId);
 
-                    road->_names.insert(stringTag, ObfReaderUtilities::encodeIntegerToString(stringId));
+                    road->_namesIds.insert(stringTag, stringId);
                 }
                 cis->PopLimit(oldLimit);
             }
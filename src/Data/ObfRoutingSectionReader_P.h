@@ -69,11 +69,13 @@ namespace OsmAnd {
             const std::shared_ptr<ObfRoutingSubsectionInfo>& parent, uint32_t depth = std::numeric_limits<uint32_t>::max());
         static void readSubsectionChildrenHeaders(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<ObfRoutingSubsectionInfo>& subsection,
             uint32_t depth = std::numeric_limits<uint32_t>::max());
-        static void readSubsectionData(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection,
+        // Returns number of roads given to results or visitor
+        static unsigned int readSubsectionData(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection,
             QList< std::shared_ptr<const Model::Road> >* resultOut = nullptr,
             QMap< uint64_t, std::shared_ptr<const Model::Road> >* resultMapOut = nullptr,
             IQueryFilter* filter = nullptr,
-            std::function<bool (const std::shared_ptr<const Model::Road>&)> visitor = nullptr);
+            std::function<bool (const std::shared_ptr<const Model::Road>&)> visitor = nullptr,
+            IQueryController* controller = nullptr);
         static void readSubsectionRoadsIds(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection,
             QList<uint64_t>& ids);
         static void readSubsectionRestriction(
@@ -104,7 +106,8 @@ namespace OsmAnd {
             QList< std::shared_ptr<const Model::Road> >* resultOut = nullptr,
             QMap< uint64_t, std::shared_ptr<const Model::Road> >* resultMapOut = nullptr,
             IQueryFilter* filter = nullptr,
-            std::function<bool (const std::shared_ptr<const OsmAnd::Model::Road>&)> visitor = nullptr);
+            std::function<bool (const std::shared_ptr<const OsmAnd::Model::Road>&)> visitor = nullptr,
+            IQueryController* controller = nullptr);
 
         static void loadSubsectionBorderBoxLinesPoints(const std::unique_ptr<ObfReader_P>& reader, const std::shared_ptr<const ObfRoutingSectionInfo>& section,
             QList< std::shared_ptr<const ObfRoutingBorderLinePoint> >* resultOut = nullptr,
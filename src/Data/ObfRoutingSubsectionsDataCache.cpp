@@ -0,0 +1,141 @@
+#include "ObfRoutingSubsectionsDataCache.h"
+
+#include "ObfReader.h"
+#include "ObfFile.h"
+#include "ObfRoutingSectionInfo.h"
+#include "Road.h"
+
+const std::shared_ptr<OsmAnd::ObfRoutingSubsectionsDataCache> OsmAnd::ObfRoutingSubsectionsDataCache::instance(new OsmAnd::ObfRoutingSubsectionsDataCache());
+
+OsmAnd::ObfRoutingSubsectionsDataCache::ObfRoutingSubsectionsDataCache()
+    : _memoryLimit(64 * 1024 * 1024)
+    , _consumedMemory(0)
+    , _hits(0)
+    , _misses(0)
+    , _evictions(0)
+{
+}
+
+OsmAnd::ObfRoutingSubsectionsDataCache::~ObfRoutingSubsectionsDataCache()
+{
+}
+
+bool OsmAnd::ObfRoutingSubsectionsDataCache::isEnabled() const
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    return (_memoryLimit > 0);
+}
+
+void OsmAnd::ObfRoutingSubsectionsDataCache::setMemoryLimit( const size_t limitInBytes )
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    _memoryLimit = limitInBytes;
+    evictUntilFits(_memoryLimit);
+}
+
+size_t OsmAnd::ObfRoutingSubsectionsDataCache::getMemoryLimit() const
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    return _memoryLimit;
+}
+
+std::shared_ptr<const OsmAnd::ObfRoutingSubsectionsDataCache::Data> OsmAnd::ObfRoutingSubsectionsDataCache::obtainData(
+    const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection )
+{
+    const auto& obfFile = reader->obfFile;
+    const Key key(obfFile.get(), subsection->offset);
+
+    if(obfFile)
+    {
+        QMutexLocker scopedLock(&_mutex);
+
+        const auto itEntry = _entries.find(key);
+        if(itEntry != _entries.end())
+        {
+            _hits++;
+
+            // Mark as most recently used
+            auto& entry = *itEntry;
+            _lru.splice(_lru.begin(), _lru, entry.lruPosition);
+
+            return entry.data;
+        }
+        _misses++;
+    }
+
+    // Decoding is done without lock, so same subsection may be decoded by several contexts simultaneously
+    std::shared_ptr<Data> data(new Data(obfFile, subsection));
+    ObfRoutingSectionReader::loadSubsectionData(reader, subsection, &data->roads);
+    if(!obfFile)
+        return data;
+
+    size_t dataConsumedMemory = sizeof(Data);
+    for(auto itRoad = data->roads.cbegin(); itRoad != data->roads.cend(); ++itRoad)
+        dataConsumedMemory += (*itRoad)->calculateApproxConsumedMemory();
+
+    QMutexLocker scopedLock(&_mutex);
+
+    if(dataConsumedMemory > _memoryLimit)
+        return data;
+
+    // Prefer data that is already shared by other contexts
+    const auto itEntry = _entries.find(key);
+    if(itEntry != _entries.end())
+        return itEntry->data;
+
+    evictUntilFits(_memoryLimit - dataConsumedMemory);
+
+    _lru.push_front(key);
+    Entry entry;
+    entry.data = data;
+    entry.consumedMemory = dataConsumedMemory;
+    entry.lruPosition = _lru.begin();
+    _entries.insert(key, entry);
+    _consumedMemory += dataConsumedMemory;
+
+    return data;
+}
+
+void OsmAnd::ObfRoutingSubsectionsDataCache::evictUntilFits( size_t memoryLimit )
+{
+    while(_consumedMemory > memoryLimit && !_lru.empty())
+    {
+        const auto itEntry = _entries.find(_lru.back());
+        _consumedMemory -= itEntry->consumedMemory;
+        _entries.erase(itEntry);
+        _lru.pop_back();
+        _evictions++;
+    }
+}
+
+OsmAnd::ObfRoutingSectionReader::SubsectionsDataCacheMetrics OsmAnd::ObfRoutingSubsectionsDataCache::getMetrics() const
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    ObfRoutingSectionReader::SubsectionsDataCacheMetrics metrics;
+    metrics.hits = _hits;
+    metrics.misses = _misses;
+    metrics.evictions = _evictions;
+    metrics.subsectionsCount = _entries.size();
+    metrics.consumedMemory = _consumedMemory;
+    metrics.memoryLimit = _memoryLimit;
+    return metrics;
+}
+
+void OsmAnd::ObfRoutingSubsectionsDataCache::clear()
+{
+    QMutexLocker scopedLock(&_mutex);
+
+    _entries.clear();
+    _lru.clear();
+    _consumedMemory = 0;
+}
+
+OsmAnd::ObfRoutingSubsectionsDataCache::Data::Data( const std::shared_ptr<const ObfFile>& obfFile_, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection_ )
+    : obfFile(obfFile_)
+    , subsection(subsection_)
+{
+}
@@ -0,0 +1,106 @@
+/**
+* @file
+*
+* @section LICENSE
+*
+* OsmAnd - Android navigation software based on OSM maps.
+* Copyright (C) 2010-2013  OsmAnd Authors listed in AUTHORS file
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __OBF_ROUTING_SUBSECTIONS_DATA_CACHE_H_
+#define __OBF_ROUTING_SUBSECTIONS_DATA_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <list>
+
+#include <QList>
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+
+#include <OsmAndCore.h>
+#include <ObfRoutingSectionReader.h>
+
+namespace OsmAnd {
+
+    class ObfFile;
+    class ObfReader;
+    class ObfRoutingSubsectionInfo;
+    namespace Model {
+        class Road;
+    } // namespace Model
+
+    // Process-wide LRU cache of decoded routing subsections, limited by approximate consumed memory.
+    // Subsections are keyed by file and their offset in it, so all readers of same file share decoded roads
+    class ObfRoutingSubsectionsDataCache
+    {
+        Q_DISABLE_COPY(ObfRoutingSubsectionsDataCache)
+    public:
+        struct Data
+        {
+            Data(const std::shared_ptr<const ObfFile>& obfFile, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection);
+
+            // Holds file, so its address can not be reused while data is cached
+            const std::shared_ptr<const ObfFile> obfFile;
+            const std::shared_ptr<const ObfRoutingSubsectionInfo> subsection;
+
+            // All roads of subsection, regardless of routing profile. Roads are immutable once cached
+            QList< std::shared_ptr<const Model::Road> > roads;
+        };
+    private:
+        typedef QPair<const ObfFile*, uint32_t> Key;
+        struct Entry
+        {
+            std::shared_ptr<const Data> data;
+            size_t consumedMemory;
+            std::list<Key>::iterator lruPosition;
+        };
+
+        mutable QMutex _mutex;
+        size_t _memoryLimit;
+        size_t _consumedMemory;
+        QHash<Key, Entry> _entries;
+        std::list<Key> _lru;
+
+        uint64_t _hits;
+        uint64_t _misses;
+        uint64_t _evictions;
+
+        void evictUntilFits(size_t memoryLimit);
+    protected:
+        ObfRoutingSubsectionsDataCache();
+    public:
+        virtual ~ObfRoutingSubsectionsDataCache();
+
+        static const std::shared_ptr<ObfRoutingSubsectionsDataCache> instance;
+
+        bool isEnabled() const;
+        void setMemoryLimit(const size_t limitInBytes);
+        size_t getMemoryLimit() const;
+
+        //! Returns decoded subsection from cache, or decodes and caches it. Subsections of readers without file
+        //! are never cached
+        std::shared_ptr<const Data> obtainData(const std::shared_ptr<ObfReader>& reader, const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection);
+
+        ObfRoutingSectionReader::SubsectionsDataCacheMetrics getMetrics() const;
+        void clear();
+    };
+
+} // namespace OsmAnd
+
+#endif // __OBF_ROUTING_SUBSECTIONS_DATA_CACHE_H_
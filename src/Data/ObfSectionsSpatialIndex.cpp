@@ -0,0 +1,148 @@
+#include "ObfSectionsSpatialIndex.h"
+
+#include <cmath>
+#include <functional>
+
+#include "ObfFile.h"
+#include "ObfSectionInfo.h"
+
+namespace OsmAnd {
+    namespace ObfSectionsSpatialIndex_Internal {
+
+        inline int64_t centerX(const AreaI& area)
+        {
+            return (static_cast<int64_t>(area.left) + area.right) / 2;
+        }
+
+        inline int64_t centerY(const AreaI& area)
+        {
+            return (static_cast<int64_t>(area.top) + area.bottom) / 2;
+        }
+
+        inline void enlargeToInclude(AreaI& area, const AreaI& that)
+        {
+            area.top = qMin(area.top, that.top);
+            area.left = qMin(area.left, that.left);
+            area.bottom = qMax(area.bottom, that.bottom);
+            area.right = qMax(area.right, that.right);
+        }
+
+        // Sort-Tile-Recursive: after sorting, each consecutive group of 'capacity' items forms compact node
+        template<typename T>
+        void sortTileRecursive(QVector<T>& items, const int capacity, std::function<const AreaI& (const T&)> getArea)
+        {
+            if(items.size() <= capacity)
+                return;
+
+            const auto nodesCount = (items.size() + capacity - 1) / capacity;
+            const auto slicesCount = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(nodesCount))));
+            const auto sliceSize = slicesCount * capacity;
+
+            qSort(items.begin(), items.end(), [getArea](const T& l, const T& r) -> bool
+            {
+                return centerX(getArea(l)) < centerX(getArea(r));
+            });
+            for(auto sliceStart = 0; sliceStart < items.size(); sliceStart += sliceSize)
+            {
+                const auto sliceEnd = qMin(sliceStart + sliceSize, items.size());
+                qSort(items.begin() + sliceStart, items.begin() + sliceEnd, [getArea](const T& l, const T& r) -> bool
+                {
+                    return centerY(getArea(l)) < centerY(getArea(r));
+                });
+            }
+        }
+
+        template<typename T, typename NODE>
+        QVector<NODE> packLevel(const QVector<T>& items, const int capacity, std::function<const AreaI& (const T&)> getArea)
+        {
+            QVector<NODE> nodes;
+            nodes.reserve((items.size() + capacity - 1) / capacity);
+            for(auto groupStart = 0; groupStart < items.size(); groupStart += capacity)
+            {
+                const auto groupEnd = qMin(groupStart + capacity, items.size());
+
+                NODE node;
+                node.area31 = getArea(items[groupStart]);
+                for(auto itemIdx = groupStart + 1; itemIdx < groupEnd; itemIdx++)
+                    enlargeToInclude(node.area31, getArea(items[itemIdx]));
+                node.firstChild = groupStart;
+                node.childrenCount = groupEnd - groupStart;
+                nodes.push_back(node);
+            }
+            return nodes;
+        }
+
+    } // namespace ObfSectionsSpatialIndex_Internal
+} // namespace OsmAnd
+
+OsmAnd::ObfSectionsSpatialIndex::ObfSectionsSpatialIndex( const QList<Entry>& entries )
+    : _entries(entries.toVector())
+{
+    using namespace ObfSectionsSpatialIndex_Internal;
+
+    if(_entries.isEmpty())
+        return;
+
+    const std::function<const AreaI& (const Entry&)> getEntryArea = [](const Entry& entry) -> const AreaI&
+    {
+        return entry.area31;
+    };
+    const std::function<const AreaI& (const Node&)> getNodeArea = [](const Node& node) -> const AreaI&
+    {
+        return node.area31;
+    };
+
+    sortTileRecursive(_entries, NodeCapacity, getEntryArea);
+    _levels.push_back(packLevel<Entry, Node>(_entries, NodeCapacity, getEntryArea));
+    while(_levels.last().size() > 1)
+    {
+        // Nodes of previous level are reordered before their parents are created, so ranges stay valid
+        sortTileRecursive(_levels.last(), NodeCapacity, getNodeArea);
+        _levels.push_back(packLevel<Node, Node>(_levels.last(), NodeCapacity, getNodeArea));
+    }
+}
+
+OsmAnd::ObfSectionsSpatialIndex::~ObfSectionsSpatialIndex()
+{
+}
+
+void OsmAnd::ObfSectionsSpatialIndex::query(
+    const AreaI& area31, const SectionType sectionType, const ZoomLevel* zoom, QList<const Entry*>& outEntries ) const
+{
+    if(_levels.isEmpty())
+        return;
+
+    const auto& root = _levels.last().first();
+    query(area31, _levels.size() - 1, root, sectionType, zoom, outEntries);
+}
+
+void OsmAnd::ObfSectionsSpatialIndex::query(
+    const AreaI& area31, const int levelIdx, const Node& node,
+    const SectionType sectionType, const ZoomLevel* zoom, QList<const Entry*>& outEntries ) const
+{
+    if(!area31.intersects(node.area31))
+        return;
+
+    const auto childrenEnd = node.firstChild + node.childrenCount;
+    if(levelIdx == 0)
+    {
+        for(auto entryIdx = node.firstChild; entryIdx < childrenEnd; entryIdx++)
+        {
+            const auto& entry = _entries[entryIdx];
+
+            if(entry.sectionType != sectionType)
+                continue;
+            if(zoom && (entry.minZoom > *zoom || entry.maxZoom < *zoom))
+                continue;
+            if(!area31.intersects(entry.area31))
+                continue;
+
+            outEntries.push_back(&entry);
+        }
+        return;
+    }
+
+    const auto& children = _levels[levelIdx - 1];
+    for(auto childIdx = node.firstChild; childIdx < childrenEnd; childIdx++)
+        query(area31, levelIdx - 1, children[childIdx], sectionType, zoom, outEntries);
+}
@@ -0,0 +1,93 @@
+/**
+* @file
+*
+* @section LICENSE
+*
+* OsmAnd - Android navigation software based on OSM maps.
+* Copyright (C) 2010-2013  OsmAnd Authors listed in AUTHORS file
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __OBF_SECTIONS_SPATIAL_INDEX_H_
+#define __OBF_SECTIONS_SPATIAL_INDEX_H_
+
+#include <cstdint>
+#include <memory>
+
+#include <QList>
+#include <QVector>
+
+#include <OsmAndCore.h>
+#include <CommonTypes.h>
+
+namespace OsmAnd {
+
+    class ObfFile;
+    class ObfSectionInfo;
+
+    // Static R-tree (packed using Sort-Tile-Recursive) over areas of map levels, routing subsection roots
+    // and POI sections of many files. It's rebuilt as a whole when set of files changes.
+    class ObfSectionsSpatialIndex
+    {
+        Q_DISABLE_COPY(ObfSectionsSpatialIndex)
+    public:
+        enum SectionType
+        {
+            MapSection,
+            RoutingSection,
+            PoiSection,
+        };
+
+        struct Entry
+        {
+            AreaI area31;
+            ZoomLevel minZoom;
+            ZoomLevel maxZoom;
+            SectionType sectionType;
+
+            std::shared_ptr<const ObfFile> file;
+            std::shared_ptr<const ObfSectionInfo> section;
+        };
+    private:
+        enum {
+            NodeCapacity = 8,
+        };
+
+        struct Node
+        {
+            AreaI area31;
+            uint32_t firstChild;
+            uint32_t childrenCount;
+        };
+
+        QVector<Entry> _entries;
+
+        // Level 0 references entries, each next level references nodes of previous one. Last level has single root node
+        QList< QVector<Node> > _levels;
+
+        void query(const AreaI& area31, const int levelIdx, const Node& node,
+            const SectionType sectionType, const ZoomLevel* zoom, QList<const Entry*>& outEntries) const;
+    protected:
+    public:
+        ObfSectionsSpatialIndex(const QList<Entry>& entries);
+        virtual ~ObfSectionsSpatialIndex();
+
+        //! Collects entries of given type, that intersect area (and contain given zoom, if specified)
+        void query(const AreaI& area31, const SectionType sectionType, const ZoomLevel* zoom, QList<const Entry*>& outEntries) const;
+    };
+
+} // namespace OsmAnd
+
+#endif // __OBF_SECTIONS_SPATIAL_INDEX_H_
@@ -0,0 +1,79 @@
+#include "ObfStringTable.h"
+
+#include <google/protobuf/wire_format_lite.h>
+
+#include "ObfReaderUtilities.h"
+
+#include "OBF.pb.h"
+
+OsmAnd::ObfStringTable::ObfStringTable()
+{
+    _offsets.push_back(0);
+}
+
+OsmAnd::ObfStringTable::~ObfStringTable()
+{
+}
+
+void OsmAnd::ObfStringTable::read( gpb::io::CodedInputStream* cis )
+{
+    // Raw strings can't be larger than table itself
+    _data.reserve(_data.size() + cis->BytesUntilLimit());
+
+    for(;;)
+    {
+        auto tag = cis->ReadTag();
+        switch(gpb::internal::WireFormatLite::GetTagFieldNumber(tag))
+        {
+        case 0:
+            _data.squeeze();
+            _offsets.squeeze();
+            return;
+        case OBF::StringTable::kSFieldNumber:
+            {
+                gpb::uint32 length;
+                cis->ReadVarint32(&length);
+
+                const auto offset = _data.size();
+                _data.resize(offset + length);
+                if(!cis->ReadRaw(_data.data() + offset, length))
+                {
+                    _data.resize(offset);
+                    break;
+                }
+                _offsets.push_back(_data.size());
+            }
+            break;
+        default:
+            ObfReaderUtilities::skipUnknownField(cis, tag);
+            break;
+        }
+    }
+}
+
+uint32_t OsmAnd::ObfStringTable::size() const
+{
+    return _offsets.size() - 1;
+}
+
+bool OsmAnd::ObfStringTable::contains( const uint32_t index ) const
+{
+    return index < size();
+}
+
+QString OsmAnd::ObfStringTable::getString( const uint32_t index ) const
+{
+    if(!contains(index))
+        return QString::fromLatin1("#%1 NOT FOUND").arg(index);
+
+    const auto offset = _offsets[index];
+    return QString::fromUtf8(_data.constData() + offset, _offsets[index + 1] - offset);
+}
+
+bool OsmAnd::ObfStringTable::isEmptyString( const uint32_t index ) const
+{
+    if(!contains(index))
+        return false;
+
+    return _offsets[index + 1] == _offsets[index];
+}
@@ -0,0 +1,62 @@
+/**
+* @file
+*
+* @section LICENSE
+*
+* OsmAnd - Android navigation software based on OSM maps.
+* Copyright (C) 2010-2013  OsmAnd Authors listed in AUTHORS file
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __OBF_STRING_TABLE_H_
+#define __OBF_STRING_TABLE_H_
+
+#include <cstdint>
+
+#include <QByteArray>
+#include <QVector>
+#include <QString>
+
+#include <google/protobuf/io/coded_stream.h>
+
+#include <OsmAndCore.h>
+
+namespace OsmAnd {
+
+    namespace gpb = google::protobuf;
+
+    // String table of data block, kept as raw UTF-8. Strings are decoded only when requested
+    class ObfStringTable
+    {
+        Q_DISABLE_COPY(ObfStringTable)
+    private:
+        QByteArray _data;
+        QVector< uint32_t > _offsets;
+    protected:
+    public:
+        ObfStringTable();
+        virtual ~ObfStringTable();
+
+        void read(gpb::io::CodedInputStream* cis);
+
+        uint32_t size() const;
+        bool contains(const uint32_t index) const;
+        QString getString(const uint32_t index) const;
+        bool isEmptyString(const uint32_t index) const;
+    };
+
+} // namespace OsmAnd
+
+#endif // __OBF_STRING_TABLE_H_
@@ -44,6 +44,86 @@ void OsmAnd::ObfsCollection::registerExplicitFile( const QString& filePath )
     registerExplicitFile(QFileInfo(filePath));
 }
 
+void OsmAnd::ObfsCollection::setMaxReadersPerFile( unsigned int maxReadersPerFile )
+{
+    QMutexLocker scopedLock(&_d->_readersPool->mutex);
+
+    _d->_readersPool->maxReadersPerFile = maxReadersPerFile;
+
+    // Drop readers that exceed new limit
+    for(auto itIdleReaders = _d->_readersPool->idleReaders.begin(); itIdleReaders != _d->_readersPool->idleReaders.end(); ++itIdleReaders)
+    {
+        auto& idleReaders = *itIdleReaders;
+        while(static_cast<unsigned int>(idleReaders.size()) > maxReadersPerFile)
+            delete idleReaders.takeLast();
+    }
+}
+
+unsigned int OsmAnd::ObfsCollection::getMaxReadersPerFile() const
+{
+    QMutexLocker scopedLock(&_d->_readersPool->mutex);
+
+    return _d->_readersPool->maxReadersPerFile;
+}
+
+void OsmAnd::ObfsCollection::setIndexFilePath( const QString& indexFilePath )
+{
+    QMutexLocker scopedLock(&_d->_sourcesMutex);
+
+    _d->_indexFilePath = indexFilePath;
+    _d->_indexLoaded = false;
+    _d->_indexOutdated = true;
+    _d->_index.clear();
+}
+
+QString OsmAnd::ObfsCollection::getIndexFilePath() const
+{
+    QMutexLocker scopedLock(&_d->_sourcesMutex);
+
+    return _d->_indexFilePath;
+}
+
+void OsmAnd::ObfsCollection::setFileSystemWatchingEnabled( bool enabled )
+{
+    QMutexLocker scopedLock(&_d->_sourcesMutex);
+
+    if(enabled == (_d->_fileSystemWatcher != nullptr))
+        return;
+
+    if(!enabled)
+    {
+        _d->disableFileSystemWatching();
+        return;
+    }
+
+    _d->enableFileSystemWatching();
+
+    // Changes made before watching was enabled are unknown, so everything is scanned again
+    invalidateSources();
+}
+
+bool OsmAnd::ObfsCollection::isFileSystemWatchingEnabled() const
+{
+    QMutexLocker scopedLock(&_d->_sourcesMutex);
+
+    return (_d->_fileSystemWatcher != nullptr);
+}
+
+void OsmAnd::ObfsCollection::invalidateSources()
+{
+    QMutexLocker scopedLock(&_d->_watchedCollectionMutex);
+
+    for(auto itEntry = _d->_watchedCollection.begin(); itEntry != _d->_watchedCollection.end(); ++itEntry)
+    {
+        const auto& entry = *itEntry;
+        if(entry->type != ObfsCollection_P::WatchEntry::WatchedDirectory)
+            continue;
+
+        std::static_pointer_cast<ObfsCollection_P::WatchedDirectoryEntry>(entry)->outdated = true;
+    }
+    _d->_watchedCollectionChanged = true;
+}
+
 std::shared_ptr<OsmAnd::ObfDataInterface> OsmAnd::ObfsCollection::obtainDataInterface() const
 {
     QMutexLocker scopedLock_sourcesMutex(&_d->_sourcesMutex);
@@ -56,14 +136,20 @@ std::shared_ptr<OsmAnd::ObfDataInterface> OsmAnd::ObfsCollection::obtainDataInte
         _d->_watchedCollectionChanged = false;
     }
 
+    // Store information of new files in index, if it's used
+    _d->updateIndex();
+
+    // Areas of all sections are needed to skip files that have nothing in query area
+    _d->updateSpatialIndex();
+
     QList< std::shared_ptr<ObfReader> > obfReaders;
     for(auto itSource = _d->_sources.begin(); itSource != _d->_sources.end(); ++itSource)
     {
         const auto& obfFile = itSource.value();
 
-        auto obfReader = new ObfReader(obfFile);
-        obfReaders.push_back(std::shared_ptr<ObfReader>(obfReader));
+        // Readers are borrowed from pool, and get returned there when data interface is released
+        obfReaders.push_back(_d->borrowReader(obfFile));
     }
 
-    return std::shared_ptr<ObfDataInterface>(new ObfDataInterface(obfReaders));
+    return std::shared_ptr<ObfDataInterface>(new ObfDataInterface(obfReaders, _d->_spatialIndex));
 }
@@ -1,8 +1,44 @@
 #include "ObfsCollection_P.h"
 #include "ObfsCollection.h"
 
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QCoreApplication>
+
 #include "ObfFile.h"
-#include "Utilities.h"
+#include "ObfFile_P.h"
+#include "ObfReader.h"
+#include "ObfReader_P.h"
+#include "ObfInfo.h"
+#include "ObfMapSectionInfo.h"
+#include "ObfRoutingSectionInfo.h"
+#include "ObfPoiSectionInfo.h"
+#include "ObfSectionsSpatialIndex.h"
+#include "OsmAndCore_private.h"
+#include "QMainThreadTaskEvent.h"
+#include "Logging.h"
+
+namespace OsmAnd {
+    namespace ObfsCollection_P_Internal {
+
+        // Same as Utilities::findFiles(), but also collects all scanned directories, so they can be watched
+        static void scanDirectory(const QDir& dir, const bool recursive, QFileInfoList& files, QStringList& scannedDirectories)
+        {
+            scannedDirectories.push_back(dir.absolutePath());
+            files.append(dir.entryInfoList(QStringList() << QLatin1String("*.obf"), QDir::Files));
+
+            if(!recursive)
+                return;
+
+            const auto& subdirs = dir.entryInfoList(QStringList(), QDir::AllDirs | QDir::NoDotAndDotDot);
+            for(auto itSubdir = subdirs.cbegin(); itSubdir != subdirs.cend(); ++itSubdir)
+                scanDirectory(QDir(itSubdir->absoluteFilePath()), recursive, files, scannedDirectories);
+        }
+
+    } // namespace ObfsCollection_P_Internal
+} // namespace OsmAnd
+using namespace OsmAnd::ObfsCollection_P_Internal;
 
 OsmAnd::ObfsCollection_P::ObfsCollection_P( ObfsCollection* owner_ )
     : owner(owner_)
@@ -10,19 +46,28 @@ OsmAnd::ObfsCollection_P::ObfsCollection_P( ObfsCollection* owner_ )
     , _watchedCollectionChanged(false)
     , _sourcesMutex(QMutex::Recursive)
     , _sourcesRefreshedOnce(false)
+    , _fileSystemWatcher(nullptr)
+    , _indexLoaded(false)
+    , _indexOutdated(false)
+    , _spatialIndexOutdated(true)
+    , _readersPool(new ReadersPool())
 {
 }
 
 OsmAnd::ObfsCollection_P::~ObfsCollection_P()
 {
+    disableFileSystemWatching();
 }
 
 void OsmAnd::ObfsCollection_P::refreshSources()
 {
     QMutexLocker scopedLock(&_sourcesMutex);
 
-    // Find all files that are present in watched entries
+    // Find all files that are present in watched entries. Directories are listed again only if they
+    // were reported as changed, otherwise result of previous scan is used
     QFileInfoList obfs;
+    QStringList directoriesToWatch;
+    QStringList filesToWatch;
     {
         QMutexLocker scopedLock(&_watchedCollectionMutex);
 
@@ -34,52 +79,445 @@ void OsmAnd::ObfsCollection_P::refreshSources()
             {
                 const auto& watchedDirEntry = std::static_pointer_cast<WatchedDirectoryEntry>(entry);
 
-                Utilities::findFiles(watchedDirEntry->dir, QStringList() << "*.obf", obfs, watchedDirEntry->recursive);
+                if(watchedDirEntry->outdated)
+                {
+                    watchedDirEntry->files.clear();
+                    watchedDirEntry->scannedDirectories.clear();
+                    scanDirectory(watchedDirEntry->dir, watchedDirEntry->recursive, watchedDirEntry->files, watchedDirEntry->scannedDirectories);
+                    watchedDirEntry->outdated = false;
+                }
+
+                obfs.append(watchedDirEntry->files);
+                directoriesToWatch.append(watchedDirEntry->scannedDirectories);
             }
             else if(entry->type == WatchEntry::ExplicitFile)
             {
                 const auto& explicitFileEntry = std::static_pointer_cast<ExplicitFileEntry>(entry);
 
-                if(explicitFileEntry->fileInfo.exists())
-                    obfs.push_back(explicitFileEntry->fileInfo);
+                obfs.push_back(explicitFileEntry->fileInfo);
+                filesToWatch.push_back(explicitFileEntry->fileInfo.absoluteFilePath());
             }
         }
     }
+    if(_fileSystemWatcher)
+        watchPaths(directoriesToWatch, filesToWatch);
 
-    // For each file in registry, ...
+    // Get actual size and modification time of each file, since file may have been replaced
+    // without its directory being listed again
+    QHash< QString, QFileInfo > presentObfs;
+    for(auto itObfFileInfo = obfs.begin(); itObfFileInfo != obfs.end(); ++itObfFileInfo)
     {
-        QMutableHashIterator< QString, std::shared_ptr<ObfFile> > itObfFileEntry(_sources);
-        while(itObfFileEntry.hasNext())
+        QFileInfo obfFileInfo(*itObfFileInfo);
+        obfFileInfo.refresh();
+        if(!obfFileInfo.exists())
+            continue;
+
+        presentObfs.insert(obfFileInfo.canonicalFilePath(), obfFileInfo);
+    }
+
+    // For each file in registry, which does not exist or was changed, remove entry.
+    // Changed files are registered again below as new ones
+    const auto registeredFiles = _sources.keys();
+    for(auto itFilePath = registeredFiles.cbegin(); itFilePath != registeredFiles.cend(); ++itFilePath)
+    {
+        const auto& filePath = *itFilePath;
+
+        const auto itPresentObf = presentObfs.constFind(filePath);
+        if(itPresentObf != presentObfs.cend())
         {
-            // ... which does not exist, ...
-            if(QFile::exists(itObfFileEntry.key()))
+            const auto& stamp = _sourcesStamps[filePath];
+            if(itPresentObf->size() == stamp.fileSize &&
+                itPresentObf->lastModified().toMSecsSinceEpoch() == stamp.fileModificationTime)
             {
-                itObfFileEntry.next();
                 continue;
             }
-
-            // ... remove entry
-            itObfFileEntry.remove();
         }
+
+        removeSource(filePath);
     }
 
     // For each file, ...
-    for(auto itObfFileInfo = obfs.begin(); itObfFileInfo != obfs.end(); ++itObfFileInfo)
+    for(auto itPresentObf = presentObfs.cbegin(); itPresentObf != presentObfs.cend(); ++itPresentObf)
     {
-        const auto& obfFileInfo = *itObfFileInfo;
-
-        const auto& obfFilePath = obfFileInfo.canonicalFilePath();
-        auto itObfFileEntry = _sources.find(obfFilePath);
+        const auto& obfFilePath = itPresentObf.key();
+        const auto& obfFileInfo = itPresentObf.value();
 
         // ... which is not yet present in registry, ...
-        if(itObfFileEntry == _sources.end())
+        if(_sources.contains(obfFilePath))
+            continue;
+
+        // ... create ObfFile
+        auto obfFile = new ObfFile(obfFilePath);
+        _sources.insert(obfFilePath, std::shared_ptr<ObfFile>(obfFile));
+        SourceStamp stamp;
+        stamp.fileSize = obfFileInfo.size();
+        stamp.fileModificationTime = obfFileInfo.lastModified().toMSecsSinceEpoch();
+        _sourcesStamps.insert(obfFilePath, stamp);
+        _spatialIndexOutdated = true;
+
+        // ... and take it's information from index, if it's still valid
+        if(!_indexFilePath.isEmpty())
         {
-            // ... create ObfFile
-            auto obfFile = new ObfFile(obfFilePath);
-            itObfFileEntry = _sources.insert(obfFilePath, std::shared_ptr<ObfFile>(obfFile));
+            if(!_indexLoaded)
+                loadIndex();
+
+            std::shared_ptr<ObfInfo> obfInfo;
+            const auto itIndexEntry = _index.constFind(obfFilePath);
+            if(itIndexEntry != _index.cend() &&
+                itIndexEntry->fileSize == stamp.fileSize &&
+                itIndexEntry->fileModificationTime == stamp.fileModificationTime)
+            {
+                QDataStream stream(itIndexEntry->serializedInfo);
+                stream.setVersion(QDataStream::Qt_5_0);
+                obfInfo = ObfReader_P::deserializeInfo(stream);
+            }
+
+            if(obfInfo)
+                obfFile->_d->_obfInfo = obfInfo;
+            else
+                _indexOutdated = true;
         }
     }
 
     // Mark that sources were refreshed at least once
     _sourcesRefreshedOnce = true;
 }
+
+void OsmAnd::ObfsCollection_P::removeSource( const QString& filePath )
+{
+    const auto itObfFileEntry = _sources.find(filePath);
+    if(itObfFileEntry == _sources.end())
+        return;
+
+    // Remove idle readers of that file, since they have it mapped. Readers that are still in use
+    // keep old file alive until released, and are not returned to pool
+    {
+        QMutexLocker scopedLock(&_readersPool->mutex);
+
+        const auto itIdleReaders = _readersPool->idleReaders.find(itObfFileEntry.value().get());
+        if(itIdleReaders != _readersPool->idleReaders.end())
+        {
+            qDeleteAll(*itIdleReaders);
+            _readersPool->idleReaders.erase(itIdleReaders);
+        }
+    }
+
+    _sources.erase(itObfFileEntry);
+    _sourcesStamps.remove(filePath);
+    _indexOutdated = true;
+    _spatialIndexOutdated = true;
+}
+
+void OsmAnd::ObfsCollection_P::enableFileSystemWatching()
+{
+    const auto watcher = new QFileSystemWatcher();
+    watcher->moveToThread(gMainThreadTaskHost->thread());
+
+    // Watcher is the context of connections, so they are gone together with it. Link may outlive both
+    const std::shared_ptr<FileSystemWatcherLink> link(new FileSystemWatcherLink());
+    link->d = this;
+    const auto notifyChange =
+        [link](const QString& path)
+        {
+            QMutexLocker scopedLock(&link->mutex);
+            if(link->d)
+                link->d->onFileSystemChanged(path);
+        };
+    QObject::connect(watcher, &QFileSystemWatcher::directoryChanged, watcher, notifyChange);
+    QObject::connect(watcher, &QFileSystemWatcher::fileChanged, watcher, notifyChange);
+
+    _fileSystemWatcherLink = link;
+    _fileSystemWatcher = watcher;
+}
+
+void OsmAnd::ObfsCollection_P::disableFileSystemWatching()
+{
+    if(!_fileSystemWatcher)
+        return;
+
+    // Cutting link waits for notification that may be running right now in main thread
+    {
+        QMutexLocker scopedLock(&_fileSystemWatcherLink->mutex);
+        _fileSystemWatcherLink->d = nullptr;
+    }
+    _fileSystemWatcherLink.reset();
+
+    // Disconnecting is thread-safe, while deletion has to happen in watcher's thread. Tasks posted
+    // earlier are processed before deferred deletion, so they never see deleted watcher
+    QObject::disconnect(_fileSystemWatcher, nullptr, nullptr, nullptr);
+    _fileSystemWatcher->deleteLater();
+    _fileSystemWatcher = nullptr;
+}
+
+void OsmAnd::ObfsCollection_P::watchPaths( const QStringList& directories, const QStringList& files )
+{
+    if(directories.isEmpty() && files.isEmpty())
+        return;
+
+    const auto watcher = _fileSystemWatcher;
+    QCoreApplication::postEvent(gMainThreadTaskHost.get(), new QMainThreadTaskEvent(
+        [watcher, directories, files]()
+        {
+            // Watcher complains about paths that are already watched
+            QStringList newPaths;
+            const auto watchedDirectories = watcher->directories();
+            for(auto itDirectory = directories.cbegin(); itDirectory != directories.cend(); ++itDirectory)
+            {
+                if(!watchedDirectories.contains(*itDirectory) && !newPaths.contains(*itDirectory))
+                    newPaths.push_back(*itDirectory);
+            }
+            const auto watchedFiles = watcher->files();
+            for(auto itFile = files.cbegin(); itFile != files.cend(); ++itFile)
+            {
+                if(!watchedFiles.contains(*itFile) && !newPaths.contains(*itFile) && QFile::exists(*itFile))
+                    newPaths.push_back(*itFile);
+            }
+
+            if(!newPaths.isEmpty())
+                watcher->addPaths(newPaths);
+        }));
+}
+
+void OsmAnd::ObfsCollection_P::onFileSystemChanged( const QString& path )
+{
+    QMutexLocker scopedLock(&_watchedCollectionMutex);
+
+    // Only directories that contain changed path have to be listed again
+    for(auto itEntry = _watchedCollection.begin(); itEntry != _watchedCollection.end(); ++itEntry)
+    {
+        const auto& entry = *itEntry;
+        if(entry->type != WatchEntry::WatchedDirectory)
+            continue;
+
+        const auto& watchedDirEntry = std::static_pointer_cast<WatchedDirectoryEntry>(entry);
+        if(watchedDirEntry->scannedDirectories.contains(path))
+            watchedDirEntry->outdated = true;
+    }
+
+    // Changed explicit files are detected by their size and modification time
+    _watchedCollectionChanged = true;
+}
+
+void OsmAnd::ObfsCollection_P::loadIndex()
+{
+    _indexLoaded = true;
+    _index.clear();
+
+    QFile indexFile(_indexFilePath);
+    if(!indexFile.open(QIODevice::ReadOnly))
+        return;
+    QDataStream stream(&indexFile);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 version;
+    stream >> version;
+    if(version != ObfReader_P::SerializedInfoVersion)
+        return;
+
+    QHash< QString, IndexEntry > index;
+    quint32 entriesCount;
+    stream >> entriesCount;
+    for(auto entryIdx = 0u; entryIdx < entriesCount && stream.status() == QDataStream::Ok; entryIdx++)
+    {
+        QString filePath;
+        IndexEntry entry;
+        stream >> filePath >> entry.fileSize >> entry.fileModificationTime >> entry.serializedInfo;
+        index.insert(filePath, entry);
+    }
+    if(stream.status() != QDataStream::Ok)
+    {
+        LogPrintf(LogSeverityLevel::Warning, "OBF index '%s' is damaged and will be rebuilt", qPrintable(_indexFilePath));
+        return;
+    }
+
+    _index = index;
+}
+
+void OsmAnd::ObfsCollection_P::saveIndex()
+{
+    // Index is written aside and then renamed over old one, so that interrupted write never leaves truncated index
+    QSaveFile indexFile(_indexFilePath);
+    if(!indexFile.open(QIODevice::WriteOnly))
+    {
+        LogPrintf(LogSeverityLevel::Warning, "Failed to write OBF index '%s'", qPrintable(_indexFilePath));
+        return;
+    }
+    QDataStream stream(&indexFile);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << static_cast<quint32>(ObfReader_P::SerializedInfoVersion);
+    stream << static_cast<quint32>(_index.size());
+    for(auto itIndexEntry = _index.cbegin(); itIndexEntry != _index.cend(); ++itIndexEntry)
+    {
+        const auto& entry = *itIndexEntry;
+
+        stream << itIndexEntry.key() << entry.fileSize << entry.fileModificationTime << entry.serializedInfo;
+    }
+
+    if(stream.status() != QDataStream::Ok)
+        indexFile.cancelWriting();
+    if(!indexFile.commit())
+        LogPrintf(LogSeverityLevel::Warning, "Failed to write OBF index '%s'", qPrintable(_indexFilePath));
+}
+
+void OsmAnd::ObfsCollection_P::updateIndex()
+{
+    QMutexLocker scopedLock(&_sourcesMutex);
+
+    if(_indexFilePath.isEmpty() || !_indexOutdated)
+        return;
+
+    QHash< QString, IndexEntry > index;
+    for(auto itSource = _sources.cbegin(); itSource != _sources.cend(); ++itSource)
+    {
+        const auto& obfFile = *itSource;
+
+        // Files that are missing in index need to be read now, to be present there next time
+        const auto obfInfo = borrowReader(obfFile)->obtainInfo();
+        if(!obfInfo || obfInfo->version < 0)
+            continue;
+
+        const auto& stamp = _sourcesStamps[itSource.key()];
+        IndexEntry entry;
+        entry.fileSize = stamp.fileSize;
+        entry.fileModificationTime = stamp.fileModificationTime;
+        QDataStream stream(&entry.serializedInfo, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_0);
+        ObfReader_P::serializeInfo(stream, obfInfo);
+        index.insert(itSource.key(), entry);
+    }
+    _index = index;
+    saveIndex();
+
+    _indexOutdated = false;
+}
+
+void OsmAnd::ObfsCollection_P::updateSpatialIndex()
+{
+    QMutexLocker scopedLock(&_sourcesMutex);
+
+    if(!_spatialIndexOutdated)
+        return;
+
+    QList<ObfSectionsSpatialIndex::Entry> entries;
+    for(auto itSource = _sources.cbegin(); itSource != _sources.cend(); ++itSource)
+    {
+        const auto& obfFile = *itSource;
+        const auto obfInfo = borrowReader(obfFile)->obtainInfo();
+
+        for(auto itMapSection = obfInfo->mapSections.cbegin(); itMapSection != obfInfo->mapSections.cend(); ++itMapSection)
+        {
+            const auto& mapSection = *itMapSection;
+
+            for(auto itLevel = mapSection->levels.cbegin(); itLevel != mapSection->levels.cend(); ++itLevel)
+            {
+                const auto& level = *itLevel;
+
+                ObfSectionsSpatialIndex::Entry entry;
+                entry.area31 = level->area31;
+                entry.minZoom = level->minZoom;
+                entry.maxZoom = level->maxZoom;
+                entry.sectionType = ObfSectionsSpatialIndex::MapSection;
+                entry.file = obfFile;
+                entry.section = mapSection;
+                entries.push_back(entry);
+            }
+        }
+
+        for(auto itRoutingSection = obfInfo->routingSections.cbegin(); itRoutingSection != obfInfo->routingSections.cend(); ++itRoutingSection)
+        {
+            const auto& routingSection = *itRoutingSection;
+
+            QList< std::shared_ptr<ObfRoutingSubsectionInfo> > rootSubsections;
+            rootSubsections << routingSection->subsections << routingSection->baseSubsections;
+            for(auto itSubsection = rootSubsections.cbegin(); itSubsection != rootSubsections.cend(); ++itSubsection)
+            {
+                ObfSectionsSpatialIndex::Entry entry;
+                entry.area31 = (*itSubsection)->area31;
+                entry.minZoom = ZoomLevel::MinZoomLevel;
+                entry.maxZoom = ZoomLevel::MaxZoomLevel;
+                entry.sectionType = ObfSectionsSpatialIndex::RoutingSection;
+                entry.file = obfFile;
+                entry.section = routingSection;
+                entries.push_back(entry);
+            }
+        }
+
+        for(auto itPoiSection = obfInfo->poiSections.cbegin(); itPoiSection != obfInfo->poiSections.cend(); ++itPoiSection)
+        {
+            const auto& poiSection = *itPoiSection;
+
+            ObfSectionsSpatialIndex::Entry entry;
+            entry.area31 = poiSection->area31;
+            entry.minZoom = ZoomLevel::MinZoomLevel;
+            entry.maxZoom = ZoomLevel::MaxZoomLevel;
+            entry.sectionType = ObfSectionsSpatialIndex::PoiSection;
+            entry.file = obfFile;
+            entry.section = poiSection;
+            entries.push_back(entry);
+        }
+    }
+
+    _spatialIndex.reset(new ObfSectionsSpatialIndex(entries));
+    _spatialIndexOutdated = false;
+}
+
+std::shared_ptr<OsmAnd::ObfReader> OsmAnd::ObfsCollection_P::borrowReader( const std::shared_ptr<ObfFile>& obfFile )
+{
+    ObfReader* obfReader = nullptr;
+    {
+        QMutexLocker scopedLock(&_readersPool->mutex);
+
+        // Take idle reader of this file, if there's any
+        auto& idleReaders = _readersPool->idleReaders[obfFile.get()];
+        if(!idleReaders.isEmpty())
+            obfReader = idleReaders.takeLast();
+    }
+
+    // Otherwise create new one, that will be returned to pool after use
+    if(!obfReader)
+        obfReader = new ObfReader(obfFile);
+
+    const std::weak_ptr<ReadersPool> pool(_readersPool);
+    return std::shared_ptr<ObfReader>(obfReader, [pool](ObfReader* reader)
+        {
+            releaseReader(pool, reader);
+        });
+}
+
+void OsmAnd::ObfsCollection_P::releaseReader( const std::weak_ptr<ReadersPool>& pool_, ObfReader* reader )
+{
+    // If collection is already gone, just destroy the reader
+    const auto pool = pool_.lock();
+    if(!pool)
+    {
+        delete reader;
+        return;
+    }
+
+    {
+        QMutexLocker scopedLock(&pool->mutex);
+
+        // Keep reader only if it's file is still registered and there's a room for it
+        const auto itIdleReaders = pool->idleReaders.find(reader->obfFile.get());
+        if(itIdleReaders != pool->idleReaders.end() && static_cast<unsigned int>(itIdleReaders->size()) < pool->maxReadersPerFile)
+        {
+            itIdleReaders->push_back(reader);
+            return;
+        }
+    }
+
+    delete reader;
+}
+
+OsmAnd::ObfsCollection_P::ReadersPool::ReadersPool()
+    : mutex(QMutex::Recursive)
+    , maxReadersPerFile(1)
+{
+}
+
+OsmAnd::ObfsCollection_P::ReadersPool::~ReadersPool()
+{
+    for(auto itIdleReaders = idleReaders.begin(); itIdleReaders != idleReaders.end(); ++itIdleReaders)
+        qDeleteAll(*itIdleReaders);
+}
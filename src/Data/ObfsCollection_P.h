@@ -29,6 +29,10 @@
 #include <QDir>
 #include <QHash>
 #include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QFileSystemWatcher>
 
 #include <OsmAndCore.h>
 #include <OsmAndCore/CommonTypes.h>
@@ -36,6 +40,8 @@
 namespace OsmAnd {
 
     class ObfFile;
+    class ObfReader;
+    class ObfSectionsSpatialIndex;
 
     class ObfsCollection;
     class ObfsCollection_P
@@ -66,11 +72,18 @@ namespace OsmAnd {
         {
             WatchedDirectoryEntry()
                 : WatchEntry(WatchedDirectory)
+                , recursive(true)
+                , outdated(true)
             {
             }
 
             QDir dir;
             bool recursive;
+
+            // Result of last scan is reused until some of scanned directories is reported as changed
+            bool outdated;
+            QFileInfoList files;
+            QStringList scannedDirectories;
         };
         struct ExplicitFileEntry : WatchEntry
         {
@@ -88,6 +101,65 @@ namespace OsmAnd {
         QHash< QString, std::shared_ptr<ObfFile> > _sources;
         bool _sourcesRefreshedOnce;
         void refreshSources();
+
+        // Size and modification time of each source at the moment it was registered. Source that no longer
+        // matches them is replaced, while unchanged ones keep their information and idle readers
+        struct SourceStamp
+        {
+            qint64 fileSize;
+            qint64 fileModificationTime;
+        };
+        QHash< QString, SourceStamp > _sourcesStamps;
+        void removeSource(const QString& filePath);
+
+        // Watcher lives in main thread, since it needs event loop to report changes. It's never
+        // touched directly from other threads: all calls to it are posted to main thread as tasks
+        QFileSystemWatcher* _fileSystemWatcher;
+        // Change notifications run in main thread, while collection may be destroyed in any other. They reach
+        // collection only through this link, which is cut under its mutex, so that no notification is left running
+        struct FileSystemWatcherLink
+        {
+            QMutex mutex;
+            ObfsCollection_P* d;
+        };
+        std::shared_ptr<FileSystemWatcherLink> _fileSystemWatcherLink;
+        void enableFileSystemWatching();
+        void disableFileSystemWatching();
+        void onFileSystemChanged(const QString& path);
+        void watchPaths(const QStringList& directories, const QStringList& files);
+
+        // Index keeps serialized information of each file, so that headers are not parsed on each start.
+        // Entry is valid only while file has same size and modification time.
+        struct IndexEntry
+        {
+            qint64 fileSize;
+            qint64 fileModificationTime;
+            QByteArray serializedInfo;
+        };
+        QString _indexFilePath;
+        bool _indexLoaded;
+        bool _indexOutdated;
+        QHash< QString, IndexEntry > _index;
+        void loadIndex();
+        void saveIndex();
+        void updateIndex();
+
+        bool _spatialIndexOutdated;
+        std::shared_ptr<const ObfSectionsSpatialIndex> _spatialIndex;
+        void updateSpatialIndex();
+
+        struct ReadersPool
+        {
+            ReadersPool();
+            ~ReadersPool();
+
+            QMutex mutex;
+            unsigned int maxReadersPerFile;
+            QHash< const ObfFile*, QList< ObfReader* > > idleReaders;
+        };
+        const std::shared_ptr<ReadersPool> _readersPool;
+        std::shared_ptr<ObfReader> borrowReader(const std::shared_ptr<ObfFile>& obfFile);
+        static void releaseReader(const std::weak_ptr<ReadersPool>& pool, ObfReader* reader);
     public:
         virtual ~ObfsCollection_P();
 
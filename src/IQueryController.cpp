@@ -7,3 +7,17 @@ OsmAnd::IQueryController::IQueryController()
 OsmAnd::IQueryController::~IQueryController()
 {
 }
+
+void OsmAnd::IQueryController::onBlockProcessed( const unsigned int objectsCount, const uint64_t bytesCount )
+{
+}
+
+bool OsmAnd::IQueryController::isTruncated() const
+{
+    return false;
+}
+
+OsmAnd::QueryStatistics* OsmAnd::IQueryController::getStatistics()
+{
+    return nullptr;
+}
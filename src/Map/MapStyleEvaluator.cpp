@@ -60,6 +60,11 @@ void OsmAnd::MapStyleEvaluator::setStringValue( const std::shared_ptr<const MapS
         _values[ref].asUInt = std::numeric_limits<uint32_t>::max();
 }
 
+void OsmAnd::MapStyleEvaluator::setStringIdValue( const std::shared_ptr<const MapStyleValueDefinition>& ref, const uint32_t& stringId )
+{
+    _values[ref].asUInt = stringId;
+}
+
 bool OsmAnd::MapStyleEvaluator::getBooleanValue( const std::shared_ptr<const MapStyleValueDefinition>& ref, bool& value ) const
 {
     const auto& itValue = _values.find(ref);
@@ -28,3 +28,8 @@ bool OsmAnd::OfflineMapRasterTileProvider::obtainTile(const TileId& tileId, cons
 {
     return _d->obtainTile(tileId, zoom, outTile);
 }
+
+void OsmAnd::OfflineMapRasterTileProvider::setDataQueryBudget( const int64_t timeLimitMs, const uint64_t maxObjects /*= 0*/, const uint64_t maxBytes /*= 0*/ )
+{
+    _d->setDataQueryBudget(timeLimitMs, maxObjects, maxBytes);
+}
@@ -2,6 +2,7 @@
 #include "OfflineMapRasterTileProvider.h"
 
 #include <cassert>
+#include <cinttypes>
 #include <chrono>
 
 #include <SkStream.h>
@@ -17,12 +18,16 @@
 #include "Rasterizer.h"
 #include "RasterizerContext.h"
 #include "RasterizerEnvironment.h"
+#include "QueryBudgetController.h"
 #include "Utilities.h"
 #include "Logging.h"
 
 OsmAnd::OfflineMapRasterTileProvider_P::OfflineMapRasterTileProvider_P( OfflineMapRasterTileProvider* owner_ )
     : owner(owner_)
     , _taskHostBridge(this)
+    , _dataQueryTimeLimitMs(-1)
+    , _dataQueryMaxObjects(0)
+    , _dataQueryMaxBytes(0)
 {
 }
 
@@ -30,6 +35,15 @@ OsmAnd::OfflineMapRasterTileProvider_P::~OfflineMapRasterTileProvider_P()
 {
 }
 
+void OsmAnd::OfflineMapRasterTileProvider_P::setDataQueryBudget( const int64_t timeLimitMs, const uint64_t maxObjects, const uint64_t maxBytes )
+{
+    QMutexLocker scopedLocker(&_dataQueryBudgetMutex);
+
+    _dataQueryTimeLimitMs = timeLimitMs;
+    _dataQueryMaxObjects = maxObjects;
+    _dataQueryMaxBytes = maxBytes;
+}
+
 bool OsmAnd::OfflineMapRasterTileProvider_P::obtainTile(const TileId& tileId, const ZoomLevel& zoom, std::shared_ptr<MapTile>& outTile)
 {
     // Get bounding box that covers this tile
@@ -43,10 +57,24 @@ bool OsmAnd::OfflineMapRasterTileProvider_P::obtainTile(const TileId& tileId, co
 #if defined(_DEBUG) || defined(DEBUG)
     const auto dataRead_Begin = std::chrono::high_resolution_clock::now();
 #endif
+    std::unique_ptr<QueryBudgetController> dataQueryController;
+    {
+        QMutexLocker scopedLocker(&_dataQueryBudgetMutex);
+
+        if(_dataQueryTimeLimitMs >= 0 || _dataQueryMaxObjects > 0 || _dataQueryMaxBytes > 0)
+            dataQueryController.reset(new QueryBudgetController(_dataQueryTimeLimitMs, _dataQueryMaxObjects, _dataQueryMaxBytes));
+    }
     bool basemapAvailable;
     MapFoundationType tileFoundation;
     dataInterface->obtainBasemapPresenceFlag(basemapAvailable, nullptr);
-    dataInterface->obtainMapObjects(&mapObjects, &tileFoundation, tileBBox31, zoom, nullptr);
+    dataInterface->obtainMapObjects(&mapObjects, &tileFoundation, tileBBox31, zoom, dataQueryController.get());
+    if(dataQueryController && dataQueryController->isTruncated())
+    {
+        // Best-effort tile is better than pool thread being held by single slow tile
+        LogPrintf(LogSeverityLevel::Warning,
+            "Map data query for %dx%d@%d was truncated after %" PRIu64 " objects and %" PRIu64 " bytes",
+            tileId.x, tileId.y, zoom, dataQueryController->getObjectsCount(), dataQueryController->getBytesCount());
+    }
 #if defined(_DEBUG) || defined(DEBUG)
     const auto dataRead_End = std::chrono::high_resolution_clock::now();
     const std::chrono::duration<float> dataRead_Elapsed = dataRead_End - dataRead_Begin;
@@ -27,6 +27,8 @@
 #include <functional>
 #include <array>
 
+#include <QMutex>
+
 #include <OsmAndCore.h>
 #include <CommonTypes.h>
 #include <Concurrent.h>
@@ -60,6 +62,12 @@ namespace OsmAnd {
         const Concurrent::TaskHost::Bridge _taskHostBridge;
         TilesCollection<TileEntry> _tiles;
 
+        mutable QMutex _dataQueryBudgetMutex;
+        int64_t _dataQueryTimeLimitMs;
+        uint64_t _dataQueryMaxObjects;
+        uint64_t _dataQueryMaxBytes;
+        void setDataQueryBudget(const int64_t timeLimitMs, const uint64_t maxObjects, const uint64_t maxBytes);
+
         bool obtainTile(const TileId& tileId, const ZoomLevel& zoom, std::shared_ptr<MapTile>& outTile);
     public:
         virtual ~OfflineMapRasterTileProvider_P();
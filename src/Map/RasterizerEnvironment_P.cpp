@@ -8,6 +8,8 @@
 #include <SkImageDecoder.h>
 #include <SkStream.h>
 
+#include "MapStyle.h"
+#include "MapStyle_P.h"
 #include "MapStyleEvaluator.h"
 #include "EmbeddedResources.h"
 #include "Utilities.h"
@@ -204,3 +206,60 @@ bool OsmAnd::RasterizerEnvironment_P::obtainBitmapShader( const QString& name, S
     outShader = *itShader;
     return true;
 }
+
+std::shared_ptr<const OsmAnd::RasterizerEnvironment_P::StyleRulesMapping> OsmAnd::RasterizerEnvironment_P::obtainStyleRulesMapping(
+    const std::shared_ptr<const Model::MapObject::EncodingDecodingRules>& rules ) const
+{
+    QMutexLocker scopedLock(&const_cast<RasterizerEnvironment_P*>(this)->_styleRulesMappingsMutex);
+
+    auto& styleRulesMappings = const_cast<RasterizerEnvironment_P*>(this)->_styleRulesMappings;
+    const auto itMapping = styleRulesMappings.constFind(rules.get());
+    if(itMapping != styleRulesMappings.cend() && !(*itMapping)->rules.expired())
+        return *itMapping;
+
+    // New mapping is needed only for new rules, which is a good moment to forget ones that are gone
+    for(auto itEntry = styleRulesMappings.begin(); itEntry != styleRulesMappings.end();)
+    {
+        if((*itEntry)->rules.expired())
+            itEntry = styleRulesMappings.erase(itEntry);
+        else
+            ++itEntry;
+    }
+
+    std::shared_ptr<StyleRulesMapping> mapping(new StyleRulesMapping());
+    mapping->rules = rules;
+
+    // Strings that style doesn't know, never match any style rule
+    StyleRulesMapping::Entry unknownEntry;
+    unknownEntry.tagStringId = std::numeric_limits<uint32_t>::max();
+    unknownEntry.valueStringId = std::numeric_limits<uint32_t>::max();
+    mapping->entries.fill(unknownEntry, rules->decodingRules.size());
+
+    const auto& style = owner->style;
+    for(auto ruleId = 0; ruleId < rules->decodingRules.size(); ruleId++)
+    {
+        const auto& decodingRule = rules->decodingRules[ruleId];
+        if(!(decodingRule.flags & Model::MapObject::EncodingDecodingRules::IsDefined))
+            continue;
+
+        const auto& tagValue = decodingRule.tagValue;
+        auto& entry = mapping->entries[ruleId];
+
+        if(!style->_d->lookupStringId(tagValue.tag, entry.tagStringId))
+            entry.tagStringId = std::numeric_limits<uint32_t>::max();
+        if(!style->_d->lookupStringId(tagValue.value, entry.valueStringId))
+            entry.valueStringId = std::numeric_limits<uint32_t>::max();
+    }
+
+    styleRulesMappings.insert(rules.get(), mapping);
+    return mapping;
+}
+
+const OsmAnd::RasterizerEnvironment_P::StyleRulesMapping::Entry& OsmAnd::RasterizerEnvironment_P::StyleRulesMapping::getEntry( uint32_t ruleId ) const
+{
+    static const Entry unknownEntry = { std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max() };
+
+    if(ruleId >= static_cast<uint32_t>(entries.size()))
+        return unknownEntry;
+    return entries[ruleId];
+}
@@ -38,6 +38,7 @@
 #include <OsmAndCore/Map/MapStyleRule.h>
 #include <OsmAndCore/Map/Rasterizer.h>
 #include <OsmAndCore/CommonTypes.h>
+#include <OsmAndCore/Data/Model/MapObject.h>
 
 class SkBitmapProcShader;
 
@@ -78,6 +79,27 @@ namespace OsmAnd {
 
         QMutex _bitmapShadersMutex;
         QHash< QString, SkBitmapProcShader* > _bitmapShaders;
+
+        QMutex _styleRulesMappingsMutex;
+    public:
+        // Style string ids of tag and value of each rule, indexed by rule id of map objects
+        struct StyleRulesMapping
+        {
+            struct Entry
+            {
+                uint32_t tagStringId;
+                uint32_t valueStringId;
+            };
+
+            // Rules are not held, so that mapping doesn't keep rules of removed sections alive. Mapping of
+            // expired rules is stale even if other rules took their address, and is dropped from cache
+            std::weak_ptr<const Model::MapObject::EncodingDecodingRules> rules;
+            QVector< Entry > entries;
+
+            const Entry& getEntry(uint32_t ruleId) const;
+        };
+    private:
+        QHash< const Model::MapObject::EncodingDecodingRules*, std::shared_ptr<const StyleRulesMapping> > _styleRulesMappings;
     public:
         virtual ~RasterizerEnvironment_P();
 
@@ -106,6 +128,7 @@ namespace OsmAnd {
         void applyTo(MapStyleEvaluator& evaluator) const;
 
         bool obtainBitmapShader(const QString& name, SkBitmapProcShader* &outShader) const;
+        std::shared_ptr<const StyleRulesMapping> obtainStyleRulesMapping(const std::shared_ptr<const Model::MapObject::EncodingDecodingRules>& rules) const;
 
     friend class OsmAnd::RasterizerEnvironment;
     };
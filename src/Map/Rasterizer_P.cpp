@@ -22,6 +22,35 @@
 #include <SkDashPathEffect.h>
 #include <SkBitmapProcShader.h>
 
+namespace OsmAnd {
+    namespace Rasterizer_P_Internal {
+
+        // Rules of map objects, that are created by rasterizer itself
+        enum SyntheticRule
+        {
+            CoastlineRule = 1,
+            LandRule,
+            CoastlineBrokenRule,
+            CoastlineLineRule,
+            LowestLayerRule,
+        };
+
+        static std::shared_ptr<const Model::MapObject::EncodingDecodingRules> createSyntheticRules()
+        {
+            std::shared_ptr<Model::MapObject::EncodingDecodingRules> rules(new Model::MapObject::EncodingDecodingRules());
+            rules->addRule(CoastlineRule, QString::fromLatin1("natural"), QString::fromLatin1("coastline"));
+            rules->addRule(LandRule, QString::fromLatin1("natural"), QString::fromLatin1("land"));
+            rules->addRule(CoastlineBrokenRule, QString::fromLatin1("natural"), QString::fromLatin1("coastline_broken"));
+            rules->addRule(CoastlineLineRule, QString::fromLatin1("natural"), QString::fromLatin1("coastline_line"));
+            rules->addRule(LowestLayerRule, QString::fromLatin1("layer"), QString::fromLatin1("-5"));
+            return rules;
+        }
+        static const std::shared_ptr<const Model::MapObject::EncodingDecodingRules> syntheticRules = createSyntheticRules();
+
+    } // namespace Rasterizer_P_Internal
+} // namespace OsmAnd
+using namespace OsmAnd::Rasterizer_P_Internal;
+
 OsmAnd::Rasterizer_P::Rasterizer_P()
 {
 }
@@ -66,7 +95,7 @@ void OsmAnd::Rasterizer_P::prepareContext(
         if(zoom < ZoomOnlyForBasemaps && !mapObject->section->isBasemap)
             continue;
 
-        if(mapObject->containsType(QString::fromLatin1("natural"), QString::fromLatin1("coastline")))
+        if(mapObject->containsTypeWithFlag(Model::MapObject::EncodingDecodingRules::IsCoastline))
         {
             if (mapObject->section->isBasemap)
                 context._basemapCoastlineObjects.push_back(mapObject);
@@ -121,7 +150,7 @@ void OsmAnd::Rasterizer_P::prepareContext(
     {
         assert(foundation != MapFoundationType::Undefined);
 
-        std::shared_ptr<Model::MapObject> bgMapObject(new Model::MapObject(nullptr));
+        std::shared_ptr<Model::MapObject> bgMapObject(new Model::MapObject(nullptr, syntheticRules));
         bgMapObject->_isArea = true;
         bgMapObject->_points31.push_back(PointI(area31.left, area31.top));
         bgMapObject->_points31.push_back(PointI(area31.right, area31.top));
@@ -129,15 +158,15 @@ void OsmAnd::Rasterizer_P::prepareContext(
         bgMapObject->_points31.push_back(PointI(area31.left, area31.bottom));
         bgMapObject->_points31.push_back(bgMapObject->_points31.first());
         if(foundation == MapFoundationType::FullWater)
-            bgMapObject->_types.push_back(TagValue(QString::fromLatin1("natural"), QString::fromLatin1("coastline")));
+            bgMapObject->_typesRuleIds.push_back(CoastlineRule);
         else if(foundation == MapFoundationType::FullLand || foundation == MapFoundationType::Mixed)
-            bgMapObject->_types.push_back(TagValue(QString::fromLatin1("natural"), QString::fromLatin1("land")));
+            bgMapObject->_typesRuleIds.push_back(LandRule);
         else
         {
             bgMapObject->_isArea = false;
-            bgMapObject->_types.push_back(TagValue(QString::fromLatin1("natural"), QString::fromLatin1("coastline_broken")));
+            bgMapObject->_typesRuleIds.push_back(CoastlineBrokenRule);
         }
-        bgMapObject->_extraTypes.push_back(TagValue(QString::fromLatin1("layer"), QString::fromLatin1("-5")));
+        bgMapObject->_extraTypesRuleIds.push_back(LowestLayerRule);
 
         assert(bgMapObject->isClosedFigure());
         context._triangulatedCoastlineObjects.push_back(bgMapObject);
@@ -282,23 +311,32 @@ void OsmAnd::Rasterizer_P::obtainPrimitives(
     const auto area31toPixelDivisor = context._precomputed31toPixelDivisor * context._precomputed31toPixelDivisor;
     
     QVector< Primitive > unfilteredLines;
+    std::shared_ptr<const RasterizerEnvironment_P::StyleRulesMapping> styleRulesMapping;
+    const Model::MapObject::EncodingDecodingRules* styleRulesMappingRules = nullptr;
     for(auto itMapObject = context._combinedMapObjects.begin(); itMapObject != context._combinedMapObjects.end(); ++itMapObject)
     {
         if(controller && controller->isAborted())
             return;
 
         auto mapObject = *itMapObject;
+
+        // Objects of same section go one after another, so mapping is rarely looked up. Rules are
+        // held by map objects for entire rasterization, so their address can't be reused meanwhile
+        if(!styleRulesMapping || styleRulesMappingRules != mapObject->rules.get())
+        {
+            styleRulesMapping = env.obtainStyleRulesMapping(mapObject->rules);
+            styleRulesMappingRules = mapObject->rules.get();
+        }
         
-        uint32_t typeIdx = 0;
-        for(auto itType = mapObject->types.begin(); itType != mapObject->types.end(); ++itType, typeIdx++)
+        for(auto typeIdx = 0u; typeIdx < static_cast<uint32_t>(mapObject->typesRuleIds.size()); typeIdx++)
         {
-            const auto& type = *itType;
+            const auto& typeMapping = styleRulesMapping->getEntry(mapObject->typesRuleIds[typeIdx]);
             auto layer = mapObject->getSimpleLayerValue();
 
             MapStyleEvaluator evaluator(env.owner->style, MapStyleRulesetType::Order, mapObject);
             env.applyTo(evaluator);
-            evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_TAG, type.tag);
-            evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, type.value);
+            evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_TAG, typeMapping.tagStringId);
+            evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, typeMapping.valueStringId);
             evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MINZOOM, context._zoom);
             evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MAXZOOM, context._zoom);
             evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_LAYER, layer);
@@ -319,6 +357,8 @@ void OsmAnd::Rasterizer_P::obtainPrimitives(
                 primitive.objectType = static_cast<PrimitiveType>(objectType);
                 primitive.zOrder = zOrder;
                 primitive.typeIndex = typeIdx;
+                primitive.tagStringId = typeMapping.tagStringId;
+                primitive.valueStringId = typeMapping.valueStringId;
 
                 if(objectType == PrimitiveType::Polygon)
                 {
@@ -417,7 +457,7 @@ void OsmAnd::Rasterizer_P::filterOutLinesByDensity(
         bool accept = true;
         const auto& primitive = in[lineIdx];
 
-        const auto& type = primitive.mapObject->_types[primitive.typeIndex];
+        const auto& type = primitive.mapObject->getType(primitive.typeIndex);
         if(type.tag == QLatin1String("highway"))
         {
             accept = false;
@@ -658,12 +698,10 @@ void OsmAnd::Rasterizer_P::rasterizePolygon(
         return;
     }
 
-    const auto& type = primitive.mapObject->_types[primitive.typeIndex];
-
     MapStyleEvaluator evaluator(env.owner->style, MapStyleRulesetType::Polygon, primitive.mapObject);
     env.applyTo(evaluator);
-    evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_TAG, type.tag);
-    evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, type.value);
+    evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_TAG, primitive.tagStringId);
+    evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, primitive.valueStringId);
     evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MINZOOM, context._zoom);
     evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MAXZOOM, context._zoom);
     if(!evaluator.evaluate())
@@ -768,12 +806,12 @@ void OsmAnd::Rasterizer_P::rasterizeLine(
     }
 
     bool ok;
-    const auto& type = primitive.mapObject->_types[primitive.typeIndex];
+    const auto& type = primitive.mapObject->getType(primitive.typeIndex);
 
     MapStyleEvaluator evaluator(env.owner->style, MapStyleRulesetType::Line, primitive.mapObject);
     env.applyTo(evaluator);
-    evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_TAG, type.tag);
-    evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, type.value);
+    evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_TAG, primitive.tagStringId);
+    evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, primitive.valueStringId);
     evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MINZOOM, context._zoom);
     evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MAXZOOM, context._zoom);
     evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_LAYER, primitive.mapObject->getSimpleLayerValue());
@@ -795,9 +833,9 @@ void OsmAnd::Rasterizer_P::rasterizeLine(
     int oneway = 0;
     if (context._zoom >= 16 && type.tag == QLatin1String("highway"))
     {
-        if (primitive.mapObject->containsType(QLatin1String("oneway"), QLatin1String("yes"), true))
+        if (primitive.mapObject->containsTypeWithFlag(Model::MapObject::EncodingDecodingRules::IsOneway, true))
             oneway = 1;
-        else if (primitive.mapObject->containsType(QLatin1String("oneway"), QLatin1String("-1"), true))
+        else if (primitive.mapObject->containsTypeWithFlag(Model::MapObject::EncodingDecodingRules::IsOnewayReverse, true))
             oneway = -1;
     }
 
@@ -1036,7 +1074,7 @@ bool OsmAnd::Rasterizer_P::polygonizeCoastlines(
     if(!coastlinePolylines.isEmpty())
     {
         // Add complete water tile with holes
-        std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr));
+        std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr, syntheticRules));
         mapObject->_points31.push_back(PointI(context._area31.left, context._area31.top));
         mapObject->_points31.push_back(PointI(context._area31.right, context._area31.top));
         mapObject->_points31.push_back(PointI(context._area31.right, context._area31.bottom));
@@ -1044,7 +1082,7 @@ bool OsmAnd::Rasterizer_P::polygonizeCoastlines(
         mapObject->_points31.push_back(mapObject->_points31.first());
         convertCoastlinePolylinesToPolygons(env, context, coastlinePolylines, mapObject->_innerPolygonsPoints31, osmId);
 
-        mapObject->_types.push_back(TagValue(QString::fromLatin1("natural"), QString::fromLatin1("coastline")));
+        mapObject->_typesRuleIds.push_back(CoastlineRule);
         mapObject->_id = osmId;
         mapObject->_isArea = true;
 
@@ -1069,10 +1107,10 @@ bool OsmAnd::Rasterizer_P::polygonizeCoastlines(
         {
             const auto& polygon = *itPolygon;
 
-            std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr));
+            std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr, syntheticRules));
             mapObject->_isArea = false;
             mapObject->_points31 = polygon;
-            mapObject->_types.push_back(TagValue(QString::fromLatin1("natural"), QString::fromLatin1("coastline_broken")));
+            mapObject->_typesRuleIds.push_back(CoastlineBrokenRule);
 
             outVectorized.push_back(mapObject);
         }
@@ -1082,10 +1120,10 @@ bool OsmAnd::Rasterizer_P::polygonizeCoastlines(
     {
         const auto& polygon = *itPolygon;
 
-        std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr));
+        std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr, syntheticRules));
         mapObject->_isArea = false;
         mapObject->_points31 = polygon;
-        mapObject->_types.push_back(TagValue(QString::fromLatin1("natural"), QString::fromLatin1("coastline_line")));
+        mapObject->_typesRuleIds.push_back(CoastlineLineRule);
 
         outVectorized.push_back(mapObject);
     }
@@ -1105,16 +1143,16 @@ bool OsmAnd::Rasterizer_P::polygonizeCoastlines(
 
         bool clockwise = isClockwiseCoastlinePolygon(polygon);
 
-        std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr));
+        std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr, syntheticRules));
         mapObject->_points31 = polygon;
         if(clockwise)
         {
-            mapObject->_types.push_back(TagValue(QString::fromLatin1("natural"), QString::fromLatin1("coastline")));
+            mapObject->_typesRuleIds.push_back(CoastlineRule);
             fullWaterObjects++;
         }
         else
         {
-            mapObject->_types.push_back(TagValue(QString::fromLatin1("natural"), QString::fromLatin1("land")));
+            mapObject->_typesRuleIds.push_back(LandRule);
             fullLandObjects++;
         }
         mapObject->_id = osmId;
@@ -1134,14 +1172,14 @@ bool OsmAnd::Rasterizer_P::polygonizeCoastlines(
             context._zoom);
 
         // Add complete water tile
-        std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr));
+        std::shared_ptr<Model::MapObject> mapObject(new Model::MapObject(nullptr, syntheticRules));
         mapObject->_points31.push_back(PointI(context._area31.left, context._area31.top));
         mapObject->_points31.push_back(PointI(context._area31.right, context._area31.top));
         mapObject->_points31.push_back(PointI(context._area31.right, context._area31.bottom));
         mapObject->_points31.push_back(PointI(context._area31.left, context._area31.bottom));
         mapObject->_points31.push_back(mapObject->_points31.first());
 
-        mapObject->_types.push_back(TagValue(QString::fromLatin1("natural"), QString::fromLatin1("coastline")));
+        mapObject->_typesRuleIds.push_back(CoastlineRule);
         mapObject->_id = osmId;
         mapObject->_isArea = true;
 
@@ -1700,21 +1738,8 @@ void OsmAnd::Rasterizer_P::collectPrimitivesTexts(
 
         const auto& primitive = *itPrimitive;
 
-        // Skip primitives without names
-        if(primitive.mapObject->names.isEmpty())
-            continue;
-        bool hasNonEmptyNames = false;
-        for(auto itName = primitive.mapObject->names.begin(); itName != primitive.mapObject->names.end(); ++itName)
-        {
-            const auto& name = itName.value();
-
-            if(!name.isEmpty())
-            {
-                hasNonEmptyNames = true;
-                break;
-            }
-        }
-        if(!hasNonEmptyNames)
+        // Skip primitives without names. Names themselves are decoded only when text is prepared
+        if(!primitive.mapObject->hasNames())
             continue;
 
         if(type == Polygons)
@@ -1766,11 +1791,10 @@ void OsmAnd::Rasterizer_P::collectPolygonText(
     }
 
     {
-        const auto& type = primitive.mapObject->_types[primitive.typeIndex];
         MapStyleEvaluator evaluator(env.owner->style, MapStyleRulesetType::Polygon, primitive.mapObject);
         env.applyTo(evaluator);
-        evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_TAG, type.tag);
-        evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, type.value);
+        evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_TAG, primitive.tagStringId);
+        evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, primitive.valueStringId);
         evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MINZOOM, context._zoom);
         evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MAXZOOM, context._zoom);
         if(!evaluator.evaluate())
@@ -1853,11 +1877,10 @@ void OsmAnd::Rasterizer_P::collectLineText(
     }
 
     {
-        const auto& type = primitive.mapObject->_types[primitive.typeIndex];
         MapStyleEvaluator evaluator(env.owner->style, MapStyleRulesetType::Line, primitive.mapObject);
         env.applyTo(evaluator);
-        evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_TAG, type.tag);
-        evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, type.value);
+        evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_TAG, primitive.tagStringId);
+        evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, primitive.valueStringId);
         evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MINZOOM, context._zoom);
         evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MAXZOOM, context._zoom);
         evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_LAYER, primitive.mapObject->getSimpleLayerValue());
@@ -1970,27 +1993,27 @@ void OsmAnd::Rasterizer_P::preparePrimitiveText(
     const RasterizerEnvironment_P& env, RasterizerContext_P& context,
     const Primitive& primitive, const PointF& point, SkPath* path )
 {
-    const auto& type = primitive.mapObject->_types[primitive.typeIndex];
-
-    for(auto itName = primitive.mapObject->names.begin(); itName != primitive.mapObject->names.end(); ++itName)
+    // Names are decoded one at a time, only for the object being rendered
+    const auto& mapObject = primitive.mapObject;
+    const auto namesCount = mapObject->getNamesCount();
+    for(auto nameIndex = 0; nameIndex < namesCount; nameIndex++)
     {
-        const auto& name = itName.value();
+        const auto name = mapObject->getName(nameIndex);
+        if(name.isEmpty())
+            continue;
 
         //TODO:name =rc->getTranslatedString(name);
         //TODO:name =rc->getReshapedString(name);
 
-        const auto& type = primitive.mapObject->_types[primitive.typeIndex];
         MapStyleEvaluator evaluator(env.owner->style, MapStyleRulesetType::Text, primitive.mapObject);
         env.applyTo(evaluator);
-        evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_TAG, type.tag);
-        evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, type.value);
+        evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_TAG, primitive.tagStringId);
+        evaluator.setStringIdValue(MapStyle::builtinValueDefinitions.INPUT_VALUE, primitive.valueStringId);
         evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MINZOOM, context._zoom);
         evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_MAXZOOM, context._zoom);
         evaluator.setIntegerValue(MapStyle::builtinValueDefinitions.INPUT_TEXT_LENGTH, name.length());
-        auto nameTag = itName.key();
-        if(nameTag == "name")
-            nameTag.clear();
-        evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_NAME_TAG, nameTag);
+        const auto& nameTag = mapObject->getNameTag(nameIndex);
+        evaluator.setStringValue(MapStyle::builtinValueDefinitions.INPUT_NAME_TAG, nameTag == QLatin1String("name") ? QString() : nameTag);
         if(!evaluator.evaluate())
             continue;
 
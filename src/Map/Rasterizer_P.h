@@ -88,6 +88,8 @@ namespace OsmAnd {
             std::shared_ptr<const Model::MapObject> mapObject;
             double zOrder;
             uint32_t typeIndex;
+            uint32_t tagStringId;
+            uint32_t valueStringId;
             PrimitiveType objectType;
         };
 
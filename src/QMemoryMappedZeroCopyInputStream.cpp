@@ -0,0 +1,107 @@
+#include "QMemoryMappedZeroCopyInputStream.h"
+
+#include <limits>
+
+namespace gpb = google::protobuf;
+
+OsmAnd::QMemoryMappedZeroCopyInputStream::QMemoryMappedZeroCopyInputStream( const std::shared_ptr<QFile>& file )
+    : _position(0)
+    , mapping(new Mapping(file))
+{
+}
+
+OsmAnd::QMemoryMappedZeroCopyInputStream::QMemoryMappedZeroCopyInputStream( const std::shared_ptr<const Mapping>& mapping_ )
+    : _position(0)
+    , mapping(mapping_)
+{
+}
+
+OsmAnd::QMemoryMappedZeroCopyInputStream::~QMemoryMappedZeroCopyInputStream()
+{
+}
+
+bool OsmAnd::QMemoryMappedZeroCopyInputStream::isMapped() const
+{
+    return mapping->isMapped();
+}
+
+bool OsmAnd::QMemoryMappedZeroCopyInputStream::Next( const void** data, int* size )
+{
+    if(!mapping->isMapped() || _position >= mapping->size)
+    {
+        *size = 0;
+        return false;
+    }
+
+    // Give all remaining data at once, limited only by what protobuf can address
+    const auto available = qMin(mapping->size - _position, static_cast<qint64>(std::numeric_limits<int>::max()));
+    *data = mapping->data + _position;
+    *size = static_cast<int>(available);
+    _position += available;
+    return true;
+}
+
+void OsmAnd::QMemoryMappedZeroCopyInputStream::BackUp( int count )
+{
+    // CodedInputStream::Seek() may back up further than last Next() returned
+    if(count > _position)
+        _position = 0;
+    else
+        _position -= count;
+}
+
+bool OsmAnd::QMemoryMappedZeroCopyInputStream::Skip( int count )
+{
+    if(_position + count > mapping->size)
+    {
+        _position = mapping->size;
+        return false;
+    }
+
+    _position += count;
+    return true;
+}
+
+gpb::int64 OsmAnd::QMemoryMappedZeroCopyInputStream::ByteCount() const
+{
+    return _position;
+}
+
+OsmAnd::QMemoryMappedZeroCopyInputStream::Mapping::Mapping( const std::shared_ptr<QFile>& file )
+    : _file(file)
+    , _closeOnDestruction(!file->isOpen())
+    , _data(nullptr)
+    , _size(0)
+    , data(_data)
+    , size(_size)
+{
+    if(!_file->isOpen())
+        _file->open(QIODevice::ReadOnly);
+    if(!_file->isOpen())
+        return;
+
+    _size = _file->size();
+    if(_size > 0)
+        _data = _file->map(0, _size);
+
+    // Nothing to hold file opened for, if mapping failed
+    if(!_data)
+    {
+        _size = 0;
+        if(_closeOnDestruction)
+            _file->close();
+    }
+}
+
+OsmAnd::QMemoryMappedZeroCopyInputStream::Mapping::~Mapping()
+{
+    if(_data)
+        _file->unmap(_data);
+    if(_closeOnDestruction && _file->isOpen())
+        _file->close();
+}
+
+bool OsmAnd::QMemoryMappedZeroCopyInputStream::Mapping::isMapped() const
+{
+    return (_data != nullptr);
+}
@@ -19,18 +19,15 @@ OsmAnd::QZeroCopyInputStream::~QZeroCopyInputStream()
 
 bool OsmAnd::QZeroCopyInputStream::Next( const void** data, int* size )
 {
-    char* buffer = new char[BufferSize];
-
-    qint64 bytesRead = _device->read(buffer, BufferSize);
+    qint64 bytesRead = _device->read(_buffer, BufferSize);
     if (bytesRead < 0 || (bytesRead == 0 && _device->atEnd()))
     {
-        delete[] buffer;
         *size = 0;
         return false;
     }
     else
     {
-        *data = buffer;
+        *data = _buffer;
         *size = bytesRead;
         return true;
     }
@@ -0,0 +1,82 @@
+#include "QueryBudgetController.h"
+
+OsmAnd::QueryBudgetController::QueryBudgetController( const int64_t timeLimitMs_, const uint64_t maxObjects_ /*= 0*/, const uint64_t maxBytes_ /*= 0*/ )
+    : _objectsCount(0)
+    , _bytesCount(0)
+    , _isAborted(0)
+    , _isTruncated(0)
+    , timeLimitMs(timeLimitMs_)
+    , maxObjects(maxObjects_)
+    , maxBytes(maxBytes_)
+{
+    _timer.start();
+}
+
+OsmAnd::QueryBudgetController::~QueryBudgetController()
+{
+}
+
+void OsmAnd::QueryBudgetController::truncate()
+{
+    _isTruncated.store(1);
+    _isAborted.store(1);
+}
+
+void OsmAnd::QueryBudgetController::abort()
+{
+    _isAborted.store(1);
+}
+
+bool OsmAnd::QueryBudgetController::isTruncated() const
+{
+    return _isTruncated.load() != 0;
+}
+
+uint64_t OsmAnd::QueryBudgetController::getObjectsCount() const
+{
+    QMutexLocker scopedLocker(&_countersMutex);
+
+    return _objectsCount;
+}
+
+uint64_t OsmAnd::QueryBudgetController::getBytesCount() const
+{
+    QMutexLocker scopedLocker(&_countersMutex);
+
+    return _bytesCount;
+}
+
+bool OsmAnd::QueryBudgetController::isAborted()
+{
+    if(_isAborted.load() != 0)
+        return true;
+
+    if(timeLimitMs >= 0 && _timer.hasExpired(timeLimitMs))
+    {
+        truncate();
+        return true;
+    }
+
+    return false;
+}
+
+void OsmAnd::QueryBudgetController::onBlockProcessed( const unsigned int objectsCount, const uint64_t bytesCount )
+{
+    QMutexLocker scopedLocker(&_countersMutex);
+
+    _objectsCount += objectsCount;
+    _bytesCount += bytesCount;
+
+    if((maxObjects > 0 && _objectsCount >= maxObjects) || (maxBytes > 0 && _bytesCount >= maxBytes))
+        truncate();
+}
+
+void OsmAnd::QueryBudgetController::attachStatistics( const std::shared_ptr<QueryStatistics>& statistics )
+{
+    _statistics = statistics;
+}
+
+OsmAnd::QueryStatistics* OsmAnd::QueryBudgetController::getStatistics()
+{
+    return _statistics.get();
+}
@@ -0,0 +1,73 @@
+#include "QueryStatistics.h"
+
+OsmAnd::QueryStatistics::QueryStatistics()
+{
+}
+
+OsmAnd::QueryStatistics::~QueryStatistics()
+{
+}
+
+void OsmAnd::QueryStatistics::add( const Counters& counters )
+{
+    QMutexLocker scopedLocker(&_mutex);
+
+    _counters += counters;
+}
+
+OsmAnd::QueryStatistics::Counters OsmAnd::QueryStatistics::get() const
+{
+    QMutexLocker scopedLocker(&_mutex);
+
+    return _counters;
+}
+
+void OsmAnd::QueryStatistics::reset()
+{
+    QMutexLocker scopedLocker(&_mutex);
+
+    _counters = Counters();
+}
+
+OsmAnd::QueryStatistics::Counters::Counters()
+    : bytesRead(0)
+    , seeksCount(0)
+    , treeNodesVisited(0)
+    , blocksRead(0)
+    , objectsDecoded(0)
+    , objectsDiscarded(0)
+    , treeTraversalTime(0)
+    , blocksDecodingTime(0)
+    , stringTablesReadingTime(0)
+{
+}
+
+OsmAnd::QueryStatistics::Counters& OsmAnd::QueryStatistics::Counters::operator+=( const Counters& that )
+{
+    bytesRead += that.bytesRead;
+    seeksCount += that.seeksCount;
+    treeNodesVisited += that.treeNodesVisited;
+    blocksRead += that.blocksRead;
+    objectsDecoded += that.objectsDecoded;
+    objectsDiscarded += that.objectsDiscarded;
+    treeTraversalTime += that.treeTraversalTime;
+    blocksDecodingTime += that.blocksDecodingTime;
+    stringTablesReadingTime += that.stringTablesReadingTime;
+
+    return *this;
+}
+
+OsmAnd::QueryStatistics::Stopwatch::Stopwatch( const bool start )
+    : _started(start)
+{
+    if(_started)
+        _timer.start();
+}
+
+uint64_t OsmAnd::QueryStatistics::Stopwatch::elapsed() const
+{
+    if(!_started)
+        return 0;
+
+    return static_cast<uint64_t>(_timer.nsecsElapsed());
+}
@@ -7,9 +7,11 @@
 #include <QtCore>
 
 #include "ObfReader.h"
+#include "ObfDataInterface.h"
 #include "ObfRoutingSectionReader.h"
 #include "ObfRoutingSectionInfo.h"
 #include "ObfRoutingSectionInfo_P.h"
+#include "ObfRoutingSubsectionsDataCache.h"
 #include "Common.h"
 #include "Logging.h"
 #include "Utilities.h"
@@ -201,10 +203,9 @@ void OsmAnd::RoutePlanner::loadRoadsFromTile( RoutePlannerContext* context, uint
     }
 }
 
-uint32_t OsmAnd::RoutePlanner::getCurrentEstimatedSize(RoutePlannerContext* context)
+size_t OsmAnd::RoutePlanner::getCurrentEstimatedSize(RoutePlannerContext* context)
 {
-    // TODO Victor
-    return context->getCurrentEstimatedSize(); // + current stack size  * 2000; //+ current queue size
+    return context->getCurrentEstimatedSize();
 }
 
 uint64_t OsmAnd::RoutePlanner::getRoutingTileId( RoutePlannerContext* context, uint32_t x31, uint32_t y31, bool dontLoad )
@@ -217,14 +218,14 @@ uint64_t OsmAnd::RoutePlanner::getRoutingTileId( RoutePlannerContext* context, u
     
     if(!dontLoad) {
         auto memoryLimit = context->_memoryUsageLimit;
-        uint32_t estimatedSize = getCurrentEstimatedSize(context);
+        const auto estimatedSize = getCurrentEstimatedSize(context);
         if ( estimatedSize > 0.9 * memoryLimit) {
             int clt = context->getCurrentlyLoadedTiles();
             context->unloadUnusedTiles(memoryLimit);
             int unloaded = clt - context->getCurrentlyLoadedTiles() ;
             if (unloaded > 0) {
-                OsmAnd::LogPrintf(LogSeverityLevel::Warning,"Unload %d tiles :  estimated size %d", unloaded,
-                                  (estimatedSize - getCurrentEstimatedSize(context)));
+                OsmAnd::LogPrintf(LogSeverityLevel::Warning,"Unload %d tiles :  estimated size decreased by %llu bytes", unloaded,
+                                  static_cast<unsigned long long>(estimatedSize - getCurrentEstimatedSize(context)));
             }
         }
     }
@@ -261,44 +262,56 @@ void OsmAnd::RoutePlanner::loadTileHeader( RoutePlannerContext* context, uint32_
     bbox31.right = (xTileId + 1) << zoomToLoad;
     bbox31.top = yTileId << zoomToLoad;
     bbox31.bottom = (yTileId + 1) << zoomToLoad;
-    PlainQueryFilter filter(nullptr, &bbox31);
 
-    for(auto itSource = context->sources.cbegin(); itSource != context->sources.cend(); ++itSource)
+    // With data interface, only routing sections whose root subsections intersect tile are visited
+    QList< std::pair< std::shared_ptr<ObfReader>, std::shared_ptr<const ObfRoutingSubsectionInfo> > > subsections;
+    if(context->dataInterface)
+        context->dataInterface->obtainRoutingSubsections(&subsections, bbox31, context->_useBasemap);
+    else
     {
-        const auto& source = *itSource;
-        
-        const auto& obfInfo = source->obtainInfo();
-        for(auto itRoutingSection = obfInfo->routingSections.cbegin(); itRoutingSection != obfInfo->routingSections.cend(); ++itRoutingSection)
+        PlainQueryFilter filter(nullptr, &bbox31);
+        for(auto itSource = context->sources.cbegin(); itSource != context->sources.cend(); ++itSource)
         {
-            const auto& routingSection = *itRoutingSection;
-
-            QList< std::shared_ptr<const ObfRoutingSubsectionInfo> > subsections;
-            ObfRoutingSectionReader::querySubsections(
-                source,
-                context->_useBasemap ? routingSection->baseSubsections : routingSection->subsections,
-                &subsections,
-                &filter,
-                [](const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection)
-                {
-                    return subsection->containsData();
-                }
-            );
-            for(auto itSubsection = subsections.begin(); itSubsection != subsections.end(); ++itSubsection)
-            {
-                auto itSubsectionContext = context->_subsectionsContextsLUT.find(itSubsection->get());
-                if(itSubsectionContext == context->_subsectionsContextsLUT.end())
-                {
-                    std::shared_ptr<RoutePlannerContext::RoutingSubsectionContext> subsectionContext(new RoutePlannerContext::RoutingSubsectionContext(context, source, *itSubsection));
-                    itSubsectionContext = context->_subsectionsContextsLUT.insert(itSubsection->get(), subsectionContext);
-                    context->_subsectionsContexts.push_back(subsectionContext);
-                }
+            const auto& source = *itSource;
 
-                subsectionsContexts.push_back(*itSubsectionContext);
+            const auto& obfInfo = source->obtainInfo();
+            for(auto itRoutingSection = obfInfo->routingSections.cbegin(); itRoutingSection != obfInfo->routingSections.cend(); ++itRoutingSection)
+            {
+                const auto& routingSection = *itRoutingSection;
+
+                ObfRoutingSectionReader::querySubsections(
+                    source,
+                    context->_useBasemap ? routingSection->baseSubsections : routingSection->subsections,
+                    nullptr,
+                    &filter,
+                    [&](const std::shared_ptr<const ObfRoutingSubsectionInfo>& subsection)
+                    {
+                        if(!subsection->containsData())
+                            return false;
 
+                        subsections.push_back(std::make_pair(source, subsection));
+                        return true;
+                    }
+                );
             }
         }
     }
 
+    for(auto itSubsection = subsections.cbegin(); itSubsection != subsections.cend(); ++itSubsection)
+    {
+        const auto& source = itSubsection->first;
+        const auto& subsection = itSubsection->second;
+
+        auto itSubsectionContext = context->_subsectionsContextsLUT.find(subsection.get());
+        if(itSubsectionContext == context->_subsectionsContextsLUT.end())
+        {
+            std::shared_ptr<RoutePlannerContext::RoutingSubsectionContext> subsectionContext(new RoutePlannerContext::RoutingSubsectionContext(context, source, subsection));
+            itSubsectionContext = context->_subsectionsContextsLUT.insert(subsection.get(), subsectionContext);
+            context->_subsectionsContexts.push_back(subsectionContext);
+        }
+
+        subsectionsContexts.push_back(*itSubsectionContext);
+    }
 }
 
 void OsmAnd::RoutePlanner::loadSubregionContext( RoutePlannerContext::RoutingSubsectionContext* context )
@@ -309,16 +322,18 @@ void OsmAnd::RoutePlanner::loadSubregionContext( RoutePlannerContext::RoutingSub
         context->owner->_routeStatistics->timeToLoadBegin = std::chrono::steady_clock::now();
     }
     context->markLoaded();
-    ObfRoutingSectionReader::loadSubsectionData(context->origin, context->subsection, nullptr, nullptr, nullptr,
-        [=] (const std::shared_ptr<const OsmAnd::Model::Road>& road)
-        {
-            if(!context->owner->profileContext->acceptsRoad(road))
-                return false;
 
-            context->registerRoad(road);
-            return false;
-        }
-    );
+    // Roads are decoded once for all contexts, and each context only builds own segments for accepted ones
+    const auto data = ObfRoutingSubsectionsDataCache::instance->obtainData(context->origin, context->subsection);
+    context->_sharedRoads = std::shared_ptr< const QList< std::shared_ptr<const Model::Road> > >(data, &data->roads);
+    for(auto itRoad = data->roads.cbegin(); itRoad != data->roads.cend(); ++itRoad)
+    {
+        const auto& road = *itRoad;
+        if(!context->owner->profileContext->acceptsRoad(road))
+            continue;
+
+        context->registerRoad(road);
+    }
 
     if(context->owner->_routeStatistics) {
         context->owner->_routeStatistics->timeToLoad += (uint64_t) (
@@ -498,26 +513,37 @@ OsmAnd::RouteCalculationResult OsmAnd::RoutePlanner::calculateRoute(
     }
 
     // Initializing priority queue to visit way segments 
-    const auto nonHeuristicRoadSegmentsComparator = []( const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& a, const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& b )
-    {
-        return roadPriorityComparator(
-            a->_distanceFromStart, a->_distanceToEnd,
-            b->_distanceFromStart, b->_distanceToEnd,
-            0.5) > 0;
-    };
-    const auto roadSegmentsComparator = [context]( const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& a, const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& b )
+    RoadSegmentsPriorityQueue graphDirectSegments(context->owner->_heuristicCoefficient);
+    RoadSegmentsPriorityQueue graphReverseSegments(context->owner->_heuristicCoefficient);
+
+    // Frontiers point to queues of this call, so they are unregistered on any return from it
+    struct SearchFrontiersRegistration
     {
-        return roadPriorityComparator(
-            a->_distanceFromStart, a->_distanceToEnd,
-            b->_distanceFromStart, b->_distanceToEnd,
-            context->owner->_heuristicCoefficient) > 0;
-    };
-    RoadSegmentsPriorityQueue graphDirectSegments(roadSegmentsComparator);
-    RoadSegmentsPriorityQueue graphReverseSegments(roadSegmentsComparator);
+        SearchFrontiersRegistration(RoutePlannerContext* owner_, const RoadSegmentsPriorityQueue* direct, const RoadSegmentsPriorityQueue* reverse)
+            : owner(owner_)
+        {
+            owner->_searchFrontiers.clear();
+            owner->_searchFrontiers.push_back(direct);
+            owner->_searchFrontiers.push_back(reverse);
+        }
+
+        ~SearchFrontiersRegistration()
+        {
+            owner->_searchFrontiers.clear();
+        }
+
+        RoutePlannerContext* const owner;
+    } searchFrontiersRegistration(context->owner, &graphDirectSegments, &graphReverseSegments);
     
     // Set to not visit one segment twice (stores road.id << X + segmentStart)
-    QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> > visitedDirectSegments;
-    QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> > visitedOppositeSegments;
+    const auto straightDistance = Utilities::distance31(
+        context->_startPoint.x, context->_startPoint.y,
+        context->_targetPoint.x, context->_targetPoint.y);
+    const auto expectedVisitedSegments = qMin(
+        static_cast<size_t>(straightDistance / 1000.0 * ExpectedVisitedSegmentsPerKm),
+        static_cast<size_t>(MaxExpectedVisitedSegments));
+    VisitedSegmentsMap visitedDirectSegments(expectedVisitedSegments);
+    VisitedSegmentsMap visitedOppositeSegments(expectedVisitedSegments);
     
     auto to = to_;
     const auto runRecalculation = checkPartialRecalculationPossible(context, visitedOppositeSegments, to);
@@ -548,14 +574,8 @@ OsmAnd::RouteCalculationResult OsmAnd::RoutePlanner::calculateRoute(
 #if TRACE_DUMP_QUEUE
         LogPrintf(LogSeverityLevel::Debug, "---------------------------------------");
         LogPrintf(LogSeverityLevel::Debug, "%s-Queue (%d):", reverseSearch ? "R" : "D", pGraphSegments->size());
-        {
-            auto queueDuplicate = *pGraphSegments;
-            while(queueDuplicate.size() > 0)
-            {
-                queueDuplicate.top()->dump("\t");
-                queueDuplicate.pop();
-            }
-        }
+        for(auto segmentIdx = 0u; segmentIdx < pGraphSegments->size(); segmentIdx++)
+            pGraphSegments->at(segmentIdx)->dump("\t");
 #endif
 
         auto segment = pGraphSegments->top();
@@ -565,11 +585,14 @@ OsmAnd::RouteCalculationResult OsmAnd::RoutePlanner::calculateRoute(
         segment->dump("> ");
 #endif
 
-        if(dynamic_cast<RoutePlannerContext::RouteCalculationFinalSegment*>(segment.get()))
+        if(segment->_isFinal)
         {
             finalSegment = segment;
             break;
         }
+        context->owner->_searchConsumedMemory = context->getConsumedMemory() +
+            graphDirectSegments.getConsumedMemory() + graphReverseSegments.getConsumedMemory() +
+            visitedDirectSegments.getConsumedMemory() + visitedOppositeSegments.getConsumedMemory();
         if(context->owner->getCurrentEstimatedSize() > context->owner->_memoryUsageLimit) {
             return OsmAnd::RouteCalculationResult("There is no enough memory " +
                                                   QString::number(context->owner->_memoryUsageLimit/(1<<20)) + " Mb");
@@ -764,9 +787,9 @@ void OsmAnd::RoutePlanner::calculateRouteSegment(
     OsmAnd::RoutePlannerContext::CalculationContext* context,
     bool reverseWaySearch,
     RoadSegmentsPriorityQueue& graphSegments,
-    QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& visitedSegments,
+    VisitedSegmentsMap& visitedSegments,
     const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& segment,
-    QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& oppositeSegments,
+    VisitedSegmentsMap& oppositeSegments,
     bool forwardDirection )
 {
     const bool initDirectionAllowed = checkIfInitialMovementAllowedOnSegment(context, reverseWaySearch, visitedSegments, segment, forwardDirection, segment->road);
@@ -859,7 +882,7 @@ void OsmAnd::RoutePlanner::calculateRouteSegment(
 
         // could be expensive calculation
         // 3. get intersected ways
-        auto nextSegment = loadRouteCalculationSegment(context->owner, point.x, point.y); // ctx.config.memoryLimitation - ctx.memoryOverhead
+        auto nextSegment = loadRouteCalculationSegment(context, point.x, point.y); // ctx.config.memoryLimitation - ctx.memoryOverhead
         if(!nextSegment) 
             continue;
         if( (nextSegment == segment || nextSegment->road->id == segment->road->id) && !nextSegment->next )
@@ -942,8 +965,8 @@ float OsmAnd::RoutePlanner::calculateTurnTime(
 
 bool OsmAnd::RoutePlanner::checkIfInitialMovementAllowedOnSegment(
     OsmAnd::RoutePlannerContext::CalculationContext* context,
-    bool reverseWaySearch, QMap<uint64_t,
-    std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& visitedSegments,
+    bool reverseWaySearch,
+    VisitedSegmentsMap& visitedSegments,
     const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& segment,
     bool forwardDirection,
     const std::shared_ptr<const Model::Road>& road )
@@ -991,7 +1014,7 @@ bool OsmAnd::RoutePlanner::checkIfOppositeSegmentWasVisited(
     bool reverseWaySearch,
     RoadSegmentsPriorityQueue& graphSegments,
     const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& segment,
-    QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& oppositeSegments,
+    VisitedSegmentsMap& oppositeSegments,
     const std::shared_ptr<const Model::Road>& road,
     uint32_t segmentEnd,
     bool forwardDirection,
@@ -1001,15 +1024,15 @@ bool OsmAnd::RoutePlanner::checkIfOppositeSegmentWasVisited(
 {
     const auto id = encodeRoutePointId(road, intervalId, !forwardDirection);
 
-    auto itOppositeSegment = oppositeSegments.find(id);
-    if(itOppositeSegment == oppositeSegments.end())
+    const auto& oppositeSegment = oppositeSegments.value(id);
+    if(!oppositeSegment)
         return false;
 
-    auto oppositeSegment = *itOppositeSegment;
     if(oppositeSegment->pointIndex != segmentEnd)
         return false;
 
-    auto finalSegment = new RoutePlannerContext::RouteCalculationFinalSegment(road, segment->pointIndex);
+    const auto finalSegment = context->allocateSegment(road, segment->pointIndex);
+    finalSegment->_isFinal = true;
     auto distStartObstacles = segment->_distanceFromStart + calculateTimeWithObstacles(context, road, segmentDist, obstaclesTime);
     finalSegment->_parent = segment->_parent;
     finalSegment->_parentEndPointIndex = segment->_parentEndPointIndex;
@@ -1018,9 +1041,7 @@ bool OsmAnd::RoutePlanner::checkIfOppositeSegmentWasVisited(
     finalSegment->_reverseWaySearch = reverseWaySearch;
     finalSegment->_opposite = oppositeSegment;
 
-    graphSegments.push(std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>(
-        dynamic_cast<RoutePlannerContext::RouteCalculationSegment*>(finalSegment)
-    ));
+    graphSegments.push(finalSegment);
     return true;
 }
 
@@ -1144,7 +1165,7 @@ bool OsmAnd::RoutePlanner::processRestrictions(
 void OsmAnd::RoutePlanner::processIntersections(
     OsmAnd::RoutePlannerContext::CalculationContext* context,
     RoadSegmentsPriorityQueue& graphSegments,
-    QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& visitedSegments,
+    VisitedSegmentsMap& visitedSegments,
     float distFromStart,
     const std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& segment, 
     uint32_t segmentEnd,
@@ -1190,7 +1211,7 @@ void OsmAnd::RoutePlanner::processIntersections(
             
             // assigned to wrong direction
             if(current->_assignedDirection == -searchDirection)
-                current.reset(new RoutePlannerContext::RouteCalculationSegment(current->road, current->pointIndex));
+                current = context->allocateSegment(current->road, current->pointIndex);
 
             if(!current->parent ||
                 roadPriorityComparator(
@@ -1198,27 +1219,8 @@ void OsmAnd::RoutePlanner::processIntersections(
                     distFromStart, distanceToEnd,
                     context->owner->_heuristicCoefficient) > 0)
             {
-                if (current->parent)
-                {
-                    //NOTE: This should be done somehow else (probably use different priority queue)
-                    RoadSegmentsPriorityQueue filteredGraphSegments;
-                    bool success = false;
-                    while (graphSegments.size() > 0)
-                    {
-                        auto segment = graphSegments.top();
-                        graphSegments.pop();
-
-                        if(segment == current)
-                        {
-                            success = true;
-                            continue;
-                        }
-
-                        filteredGraphSegments.push(segment);
-                    }
-                    OSMAND_ASSERT(success, "Should be handled by direction flag");
-                    graphSegments = filteredGraphSegments;
-                } 
+                // Segment, that is already queued, is moved to its new place in queue instead of being queued twice
+                OSMAND_ASSERT(!current->parent || graphSegments.contains(current), "Should be handled by direction flag");
                 current->_assignedDirection = searchDirection;
                 current->_distanceFromStart = distFromStart;
                 current->_distanceToEnd = distanceToEnd;
@@ -1233,7 +1235,7 @@ void OsmAnd::RoutePlanner::processIntersections(
                 current->dump("\t>> ");
 #endif
 
-                graphSegments.push(current);
+                graphSegments.update(current);
             }
 #if TRACE_ROUTING
             else
@@ -1292,7 +1294,7 @@ void OsmAnd::RoutePlanner::processIntersections(
 
 bool OsmAnd::RoutePlanner::checkPartialRecalculationPossible(
     OsmAnd::RoutePlannerContext::CalculationContext* context,
-    QMap<uint64_t, std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> >& visitedOppositeSegments,
+    VisitedSegmentsMap& visitedOppositeSegments,
     std::shared_ptr<RoutePlannerContext::RouteCalculationSegment>& outSegment)
 {
     if(context->owner->_previouslyCalculatedRoute.isEmpty() || qFuzzyCompare(context->owner->_partialRecalculationDistanceLimit, 0))
@@ -1384,9 +1386,11 @@ void OsmAnd::RoutePlanner::updateDistanceForBorderPoints( RoutePlannerContext::C
 }
 
 std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment> OsmAnd::RoutePlanner::loadRouteCalculationSegment(
-    OsmAnd::RoutePlannerContext* context,
+    OsmAnd::RoutePlannerContext::CalculationContext* calculationContext,
     uint32_t x31, uint32_t y31)
 {
+    const auto context = calculationContext->owner;
+
     auto tileId = getRoutingTileId(context, x31, y31, false);
 
     QMap<uint64_t, std::shared_ptr<const Model::Road> > processed;
@@ -1410,7 +1414,7 @@ std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment> OsmAnd::Ro
 
                 processed.insert(id, road);
 
-                std::shared_ptr<RoutePlannerContext::RouteCalculationSegment> segment(new RoutePlannerContext::RouteCalculationSegment(road, pointIdx));
+                const auto segment = calculationContext->allocateSegment(road, pointIdx);
                 segment->_next = original;
                 original = segment;
             }
@@ -1424,7 +1428,7 @@ std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment> OsmAnd::Ro
         for(auto itSubregionsContext = subregionsContexts.begin(); itSubregionsContext != subregionsContexts.end(); ++itSubregionsContext)
         {
             auto subregionsContext = *itSubregionsContext;
-            original = subregionsContext->loadRouteCalculationSegment(x31, y31, processed, original);
+            original = subregionsContext->loadRouteCalculationSegment(calculationContext, x31, y31, processed, original);
         }
     }
 
@@ -6,6 +6,138 @@
 #include "OsmAndCore/Utilities.h"
 #include "ObfReader.h"
 
+class OsmAnd::RoutePlannerContext::RouteCalculationSegmentsPool
+{
+    Q_DISABLE_COPY(RouteCalculationSegmentsPool)
+private:
+    enum {
+        ChunkSize = 64 * 1024,
+        Alignment = 16,
+        MaxSizeClasses = 4,
+    };
+
+    // Released slot is reused by next allocation of same size
+    struct FreeSlot
+    {
+        FreeSlot* next;
+    };
+
+    struct SizeClass
+    {
+        size_t size;
+        FreeSlot* freeSlots;
+    };
+    SizeClass _sizeClasses[MaxSizeClasses];
+    unsigned int _sizeClassesCount;
+    SizeClass* findSizeClass(const size_t size, const bool create);
+
+    QList<char*> _chunks;
+    char* _chunkCursor;
+    size_t _chunkBytesLeft;
+protected:
+public:
+    RouteCalculationSegmentsPool();
+    ~RouteCalculationSegmentsPool();
+
+    void* allocate(size_t size);
+    void deallocate(void* ptr, size_t size);
+
+    size_t getConsumedMemory() const;
+};
+
+namespace OsmAnd
+{
+    namespace RoutePlannerContext_Internal
+    {
+        // Allocates control blocks of segments' shared pointers from pool
+        template<typename T>
+        class RouteCalculationSegmentsPoolAllocator
+        {
+        public:
+            typedef T value_type;
+            typedef T* pointer;
+            typedef const T* const_pointer;
+            typedef T& reference;
+            typedef const T& const_reference;
+            typedef size_t size_type;
+            typedef ptrdiff_t difference_type;
+
+            template<typename U>
+            struct rebind
+            {
+                typedef RouteCalculationSegmentsPoolAllocator<U> other;
+            };
+
+            explicit RouteCalculationSegmentsPoolAllocator(RoutePlannerContext::RouteCalculationSegmentsPool* pool_)
+                : pool(pool_)
+            {
+            }
+
+            template<typename U>
+            RouteCalculationSegmentsPoolAllocator(const RouteCalculationSegmentsPoolAllocator<U>& that)
+                : pool(that.pool)
+            {
+            }
+
+            T* allocate(size_t count, const void* hint = nullptr)
+            {
+                return static_cast<T*>(pool->allocate(count * sizeof(T)));
+            }
+
+            void deallocate(T* ptr, size_t count)
+            {
+                pool->deallocate(ptr, count * sizeof(T));
+            }
+
+            void construct(T* ptr, const T& value)
+            {
+                new(ptr) T(value);
+            }
+
+            void destroy(T* ptr)
+            {
+                ptr->~T();
+            }
+
+            size_t max_size() const
+            {
+                return std::numeric_limits<size_t>::max() / sizeof(T);
+            }
+
+            RoutePlannerContext::RouteCalculationSegmentsPool* pool;
+        };
+
+        template<typename T, typename U>
+        inline bool operator==(const RouteCalculationSegmentsPoolAllocator<T>& l, const RouteCalculationSegmentsPoolAllocator<U>& r)
+        {
+            return l.pool == r.pool;
+        }
+
+        template<typename T, typename U>
+        inline bool operator!=(const RouteCalculationSegmentsPoolAllocator<T>& l, const RouteCalculationSegmentsPoolAllocator<U>& r)
+        {
+            return l.pool != r.pool;
+        }
+
+        struct RouteCalculationSegmentDeleter
+        {
+            RouteCalculationSegmentDeleter(RoutePlannerContext::RouteCalculationSegmentsPool* pool_)
+                : pool(pool_)
+            {
+            }
+
+            void operator()(RoutePlannerContext::RouteCalculationSegment* segment) const
+            {
+                segment->~RouteCalculationSegment();
+                pool->deallocate(segment, sizeof(RoutePlannerContext::RouteCalculationSegment));
+            }
+
+            RoutePlannerContext::RouteCalculationSegmentsPool* pool;
+        };
+    }
+}
+using namespace OsmAnd::RoutePlannerContext_Internal;
+
 OsmAnd::RoutePlannerContext::RoutePlannerContext(
     const QList< std::shared_ptr<ObfReader> >& sources,
     const std::shared_ptr<RoutingConfiguration>& routingConfig,
@@ -13,12 +145,17 @@ OsmAnd::RoutePlannerContext::RoutePlannerContext(
     bool useBasemap,
     float initialHeading /*= std::numeric_limits<float>::quiet_NaN()*/,
     QHash<QString, QString>* options /*=nullptr*/,
-    size_t memoryLimit  )
+    size_t memoryLimit /*= DefaultMemoryUsageLimit*/,
+    const std::shared_ptr<ObfDataInterface>& dataInterface /*= nullptr*/ )
     : _useBasemap(useBasemap)
     , _memoryUsageLimit(memoryLimit)
+    , _roadsConsumedMemory(0)
+    , _searchConsumedMemory(0)
+    , _accessClock(0)
     , _loadedTiles(0)
     , _initialHeading(initialHeading)
     , sources(sources)
+    , dataInterface(dataInterface)
     , configuration(routingConfig)
     , _routeStatistics(new RouteStatistics)
     , profileContext(new RoutingProfileContext(configuration->routingProfiles[vehicle], options))
@@ -46,6 +183,9 @@ OsmAnd::RoutePlannerContext::RoutingSubsectionContext::RoutingSubsectionContext(
     : subsection(subsection)
     , owner(owner)
     ,_mixedLoadsCounter(0)
+    , _access(0)
+    , _lastAccessTime(0)
+    , _consumedMemory(0)
     , origin(origin)
 {
 }
@@ -66,48 +206,58 @@ uint32_t OsmAnd::RoutePlannerContext::getCurrentlyLoadedTiles() {
     return cnt;
 }
 
-int intpow(int base, int pw) {
-    int r = 1;
-    for (int i = 0; i < pw; i++) {
-        r *= base;
-    }
-    return r;
-}
-
-
-uint32_t OsmAnd::RoutePlannerContext::getCurrentEstimatedSize() {
-    // TODO proper clculation
-    return getCurrentlyLoadedTiles()*1000;
+size_t OsmAnd::RoutePlannerContext::getCurrentEstimatedSize() const
+{
+    return _roadsConsumedMemory + _searchConsumedMemory;
 }
 
-int compareSections(std::shared_ptr<OsmAnd::RoutePlannerContext::RoutingSubsectionContext> o1,
-                    std::shared_ptr<OsmAnd::RoutePlannerContext::RoutingSubsectionContext> o2) {
-    int v1 = (o1->getAccessCounter() + 1) * intpow(10, o1->getLoadsCounter() -1);
-    int v2 = (o2->getAccessCounter() + 1) * intpow(10, o1->getLoadsCounter() -1);
-    //return v1 < v2 ? -1 : (v1 == v2 ? 0 : 1);
-    return v1 < v2;
+bool OsmAnd::RoutePlannerContext::isLessValuableSubsection(
+    const std::shared_ptr<RoutingSubsectionContext>& l, const std::shared_ptr<RoutingSubsectionContext>& r)
+{
+    // Least recently used subsection goes first. Of those used at same time, least frequently used one goes first
+    if(l->_lastAccessTime != r->_lastAccessTime)
+        return l->_lastAccessTime < r->_lastAccessTime;
+    return l->_access < r->_access;
 }
 
-
 void OsmAnd::RoutePlannerContext::unloadUnusedTiles(size_t memoryTarget) {
     float desirableSize = memoryTarget * 0.7f;
+
     QList< std::shared_ptr<RoutingSubsectionContext> > list;
     int loaded = 0;
     for(std::shared_ptr<RoutingSubsectionContext>  t : this->_subsectionsContexts) {
         if(t->isLoaded()) {
-            list.append(t);
             loaded++;
+            list.append(t);
         }
     }
     if(_routeStatistics) {
         _routeStatistics->maxLoadedTiles = qMax(_routeStatistics->maxLoadedTiles , getCurrentlyLoadedTiles());
     }
-    qSort(list.begin(), list.end(), compareSections);
+    qSort(list.begin(), list.end(), isLessValuableSubsection);
+
+    // Subsections with segments in frontier of running search will be needed right away, so they're never unloaded.
+    // Frontiers are large, so they're scanned only once something is actually going to be unloaded
+    QSet<const ObfRoutingSubsectionInfo*> frontierSubsections;
+    bool frontierSubsectionsCollected = false;
 
+    int unloaded = 0;
     int i = 0;
-    while(getCurrentEstimatedSize() >= desirableSize && (list.size() - i) > loaded / 5 && i < list.size()) {
+    while(getCurrentEstimatedSize() >= desirableSize && (loaded - unloaded) > loaded / 5 && i < list.size()) {
         std::shared_ptr<RoutingSubsectionContext>  unload = list[i];
         i++;
+        if(!frontierSubsectionsCollected) {
+            for(auto itFrontier = _searchFrontiers.cbegin(); itFrontier != _searchFrontiers.cend(); ++itFrontier)
+            {
+                const auto& frontier = *itFrontier;
+                for(auto segmentIdx = 0u; segmentIdx < frontier->size(); segmentIdx++)
+                    frontierSubsections.insert(frontier->at(segmentIdx)->road->subsection.get());
+            }
+            frontierSubsectionsCollected = true;
+        }
+        if(frontierSubsections.contains(unload->subsection.get()))
+            continue;
+        unloaded++;
         unload->unload();
         if(_routeStatistics) {
             _routeStatistics->unloadedTiles ++;
@@ -125,6 +275,10 @@ void OsmAnd::RoutePlannerContext::unloadUnusedTiles(size_t memoryTarget) {
 
 void OsmAnd::RoutePlannerContext::RoutingSubsectionContext::registerRoad( const std::shared_ptr<const Model::Road>& road )
 {
+    // Each point costs segment with control block of its shared pointer, and map node for new locations
+    size_t consumedMemory = road->calculateApproxConsumedMemory();
+    consumedMemory += road->points.size() * (sizeof(RouteCalculationSegment) + 4 * sizeof(void*));
+
     uint32_t idx = 0;
     for(auto itPoint = road->points.begin(); itPoint != road->points.end(); ++itPoint, idx++)
     {
@@ -135,7 +289,10 @@ void OsmAnd::RoutePlannerContext::RoutingSubsectionContext::registerRoad( const
         std::shared_ptr<RouteCalculationSegment> routeSegment(new RouteCalculationSegment(road, idx));
         auto itRouteSegment = _roadSegments.find(id);
         if(itRouteSegment == _roadSegments.end())
+        {
             _roadSegments.insert(id, routeSegment);
+            consumedMemory += sizeof(uint64_t) + 4 * sizeof(void*);
+        }
         else
         {
             auto originalRouteSegment = *itRouteSegment;
@@ -144,6 +301,9 @@ void OsmAnd::RoutePlannerContext::RoutingSubsectionContext::registerRoad( const
             originalRouteSegment->_next = routeSegment;
         }
     }
+
+    _consumedMemory += consumedMemory;
+    owner->_roadsConsumedMemory += consumedMemory;
 }
 
 bool OsmAnd::RoutePlannerContext::RoutingSubsectionContext::isLoaded() const
@@ -197,15 +357,23 @@ void OsmAnd::RoutePlannerContext::RoutingSubsectionContext::collectRoads( QList<
 void OsmAnd::RoutePlannerContext::RoutingSubsectionContext::markLoaded()
 {
     _mixedLoadsCounter = qAbs(_mixedLoadsCounter) + 1;
+
+    // Subsection is loaded because it's needed right now
+    _lastAccessTime = ++owner->_accessClock;
 }
 
 void OsmAnd::RoutePlannerContext::RoutingSubsectionContext::unload()
 {
     _mixedLoadsCounter = -qAbs(_mixedLoadsCounter);
     _roadSegments.clear();
+    _sharedRoads.reset();
+
+    owner->_roadsConsumedMemory -= _consumedMemory;
+    _consumedMemory = 0;
 }
 
 std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment> OsmAnd::RoutePlannerContext::RoutingSubsectionContext::loadRouteCalculationSegment(
+    CalculationContext* calculationContext,
     uint32_t x31, uint32_t y31,
     QMap<uint64_t, std::shared_ptr<const Model::Road> >& processed,
     const std::shared_ptr<RouteCalculationSegment>& original_)
@@ -215,6 +383,7 @@ std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment> OsmAnd::Ro
     if(itSegment == _roadSegments.end())
         return original_;
     this->_access++;
+    _lastAccessTime = ++owner->_accessClock;
 
     auto original = original_;
     auto segment = *itSegment;
@@ -227,7 +396,7 @@ std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment> OsmAnd::Ro
         {
             processed.insert(roadPointId, road);
 
-            std::shared_ptr<RouteCalculationSegment> newSegment(new RouteCalculationSegment(road, segment->pointIndex));
+            const auto newSegment = calculationContext->allocateSegment(road, segment->pointIndex);
             newSegment->_next = original;
             original = newSegment;
         }
@@ -240,16 +409,37 @@ std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment> OsmAnd::Ro
 
 OsmAnd::RoutePlannerContext::CalculationContext::CalculationContext( RoutePlannerContext* owner )
     : owner(owner)
+    , _segmentsPool(new RouteCalculationSegmentsPool())
 {
 }
 
 OsmAnd::RoutePlannerContext::CalculationContext::~CalculationContext()
 {
+    // Search structures are gone along with segments pool
+    owner->_searchConsumedMemory = 0;
+}
+
+size_t OsmAnd::RoutePlannerContext::CalculationContext::getConsumedMemory() const
+{
+    return _segmentsPool->getConsumedMemory();
+}
+
+std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment> OsmAnd::RoutePlannerContext::CalculationContext::allocateSegment(
+    const std::shared_ptr<const Model::Road>& road, uint32_t pointIndex )
+{
+    const auto pool = _segmentsPool.get();
+    const auto segment = new(pool->allocate(sizeof(RouteCalculationSegment))) RouteCalculationSegment(road, pointIndex);
+    return std::shared_ptr<RouteCalculationSegment>(segment,
+        RouteCalculationSegmentDeleter(pool),
+        RouteCalculationSegmentsPoolAllocator<RouteCalculationSegment>(pool));
 }
 
 OsmAnd::RoutePlannerContext::RouteCalculationSegment::RouteCalculationSegment( const std::shared_ptr<const Model::Road>& road_, uint32_t pointIndex )
     : _distanceFromStart(0)
     , _distanceToEnd(0)
+    , _queueIndex(NotQueued)
+    , _isFinal(false)
+    , _reverseWaySearch(false)
     , next(_next)
     , parent(_parent)
     , parentEndPointIndex(_parentEndPointIndex)
@@ -281,14 +471,324 @@ void OsmAnd::RoutePlannerContext::RouteCalculationSegment::dump(const QString& p
     }
 }
 
-OsmAnd::RoutePlannerContext::RouteCalculationFinalSegment::RouteCalculationFinalSegment( const std::shared_ptr<const Model::Road>& road, uint32_t pointIndex )
-    : RouteCalculationSegment(road, pointIndex)
-    , reverseWaySearch(_reverseWaySearch)
-    , opposite(_opposite)
+OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::RouteCalculationSegmentsQueue( const double heuristicCoefficient )
+    : _heuristicCoefficient(heuristicCoefficient)
+{
+}
+
+OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::~RouteCalculationSegmentsQueue()
+{
+    // Segments may outlive queue, being parents of other segments
+    for(auto itEntry = _heap.begin(); itEntry != _heap.end(); ++itEntry)
+        itEntry->segment->_queueIndex = RouteCalculationSegment::NotQueued;
+}
+
+double OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::getPriority( const RouteCalculationSegment* segment ) const
+{
+    return segment->_distanceFromStart + _heuristicCoefficient * segment->_distanceToEnd;
+}
+
+bool OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::empty() const
+{
+    return _heap.empty();
+}
+
+size_t OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::size() const
+{
+    return _heap.size();
+}
+
+const std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment>& OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::top() const
+{
+    return _heap.front().segment;
+}
+
+const std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment>& OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::at( const size_t index ) const
+{
+    return _heap[index].segment;
+}
+
+size_t OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::getConsumedMemory() const
+{
+    return _heap.capacity() * sizeof(Entry);
+}
+
+bool OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::contains( const std::shared_ptr<RouteCalculationSegment>& segment ) const
+{
+    const auto index = segment->_queueIndex;
+    return index < _heap.size() && _heap[index].segment == segment;
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::push( const std::shared_ptr<RouteCalculationSegment>& segment )
+{
+    Entry entry;
+    entry.priority = getPriority(segment.get());
+    entry.segment = segment;
+
+    const auto index = static_cast<uint32_t>(_heap.size());
+    segment->_queueIndex = index;
+    _heap.push_back(std::move(entry));
+    siftUp(index);
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::pop()
+{
+    _heap.front().segment->_queueIndex = RouteCalculationSegment::NotQueued;
+    if(_heap.size() > 1)
+    {
+        _heap.front() = std::move(_heap.back());
+        _heap.front().segment->_queueIndex = 0;
+    }
+    _heap.pop_back();
+
+    if(!_heap.empty())
+        siftDown(0);
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::update( const std::shared_ptr<RouteCalculationSegment>& segment )
+{
+    if(!contains(segment))
+    {
+        push(segment);
+        return;
+    }
+
+    const auto index = segment->_queueIndex;
+    auto& entry = _heap[index];
+    const auto oldPriority = entry.priority;
+    entry.priority = getPriority(segment.get());
+    if(entry.priority < oldPriority)
+        siftUp(index);
+    else
+        siftDown(index);
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::siftUp( uint32_t index )
+{
+    auto entry = std::move(_heap[index]);
+    while(index > 0)
+    {
+        const auto parentIndex = (index - 1) / Arity;
+        if(!(entry.priority < _heap[parentIndex].priority))
+            break;
+
+        _heap[index] = std::move(_heap[parentIndex]);
+        _heap[index].segment->_queueIndex = index;
+        index = parentIndex;
+    }
+    entry.segment->_queueIndex = index;
+    _heap[index] = std::move(entry);
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsQueue::siftDown( uint32_t index )
+{
+    const auto count = static_cast<uint32_t>(_heap.size());
+    auto entry = std::move(_heap[index]);
+    for(;;)
+    {
+        const auto firstChildIndex = index * Arity + 1;
+        if(firstChildIndex >= count)
+            break;
+
+        // Children of node are stored next to each other, so they're compared without leaving cache line
+        auto bestChildIndex = firstChildIndex;
+        const auto lastChildIndex = qMin(firstChildIndex + Arity, count);
+        for(auto childIndex = firstChildIndex + 1; childIndex < lastChildIndex; childIndex++)
+        {
+            if(_heap[childIndex].priority < _heap[bestChildIndex].priority)
+                bestChildIndex = childIndex;
+        }
+        if(!(_heap[bestChildIndex].priority < entry.priority))
+            break;
+
+        _heap[index] = std::move(_heap[bestChildIndex]);
+        _heap[index].segment->_queueIndex = index;
+        index = bestChildIndex;
+    }
+    entry.segment->_queueIndex = index;
+    _heap[index] = std::move(entry);
+}
+
+OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::RouteCalculationSegmentsVisitedMap( const size_t expectedSize /*= 0*/ )
+    : _capacityBits(0)
+    , _size(0)
+{
+    reserve(expectedSize);
+}
+
+OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::~RouteCalculationSegmentsVisitedMap()
+{
+}
+
+size_t OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::size() const
+{
+    return _size;
+}
+
+bool OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::isEmpty() const
+{
+    return _size == 0;
+}
+
+size_t OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::getConsumedMemory() const
+{
+    return _slots.capacity() * sizeof(Slot);
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::reserve( const size_t expectedSize )
+{
+    // Table is kept at most half full, so that probe sequences stay short
+    auto capacityBits = static_cast<unsigned int>(MinCapacityBits);
+    while((static_cast<size_t>(1) << capacityBits) < expectedSize * 2)
+        capacityBits++;
+
+    if(capacityBits > _capacityBits)
+        rehash(capacityBits);
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::clear()
+{
+    if(_size == 0)
+        return;
+
+    for(auto itSlot = _slots.begin(); itSlot != _slots.end(); ++itSlot)
+        itSlot->segment.reset();
+    _size = 0;
+}
+
+size_t OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::findSlot( const uint64_t id ) const
+{
+    // Ids differ mostly in high bits (road id), so they're mixed before taking slot index
+    const auto mask = _slots.size() - 1;
+    auto slotIdx = static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> (64 - _capacityBits));
+    for(;;)
+    {
+        const auto& slot = _slots[slotIdx];
+        if(!slot.segment || slot.id == id)
+            return slotIdx;
+        slotIdx = (slotIdx + 1) & mask;
+    }
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::rehash( const unsigned int capacityBits )
+{
+    std::vector<Slot> oldSlots(static_cast<size_t>(1) << capacityBits);
+    oldSlots.swap(_slots);
+    _capacityBits = capacityBits;
+
+    for(auto itSlot = oldSlots.begin(); itSlot != oldSlots.end(); ++itSlot)
+    {
+        if(!itSlot->segment)
+            continue;
+
+        auto& slot = _slots[findSlot(itSlot->id)];
+        slot.id = itSlot->id;
+        slot.segment = std::move(itSlot->segment);
+    }
+}
+
+bool OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::contains( const uint64_t id ) const
+{
+    return static_cast<bool>(_slots[findSlot(id)].segment);
+}
+
+const std::shared_ptr<OsmAnd::RoutePlannerContext::RouteCalculationSegment>& OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::value( const uint64_t id ) const
+{
+    return _slots[findSlot(id)].segment;
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsVisitedMap::insert( const uint64_t id, const std::shared_ptr<RouteCalculationSegment>& segment )
+{
+    auto slotIdx = findSlot(id);
+    if(!_slots[slotIdx].segment)
+    {
+        if((_size + 1) * 2 > _slots.size())
+        {
+            rehash(_capacityBits + 1);
+            slotIdx = findSlot(id);
+        }
+        _size++;
+    }
+
+    auto& slot = _slots[slotIdx];
+    slot.id = id;
+    slot.segment = segment;
+}
+
+OsmAnd::RoutePlannerContext::RouteCalculationSegmentsPool::RouteCalculationSegmentsPool()
+    : _sizeClassesCount(0)
+    , _chunkCursor(nullptr)
+    , _chunkBytesLeft(0)
 {
 }
 
-OsmAnd::RoutePlannerContext::RouteCalculationFinalSegment::~RouteCalculationFinalSegment()
+OsmAnd::RoutePlannerContext::RouteCalculationSegmentsPool::~RouteCalculationSegmentsPool()
 {
+    for(auto itChunk = _chunks.begin(); itChunk != _chunks.end(); ++itChunk)
+        ::operator delete(*itChunk);
+}
+
+OsmAnd::RoutePlannerContext::RouteCalculationSegmentsPool::SizeClass* OsmAnd::RoutePlannerContext::RouteCalculationSegmentsPool::findSizeClass( const size_t size, const bool create )
+{
+    for(auto sizeClassIdx = 0u; sizeClassIdx < _sizeClassesCount; sizeClassIdx++)
+    {
+        if(_sizeClasses[sizeClassIdx].size == size)
+            return &_sizeClasses[sizeClassIdx];
+    }
+    if(!create || _sizeClassesCount == MaxSizeClasses || size > ChunkSize / 4)
+        return nullptr;
+
+    auto& sizeClass = _sizeClasses[_sizeClassesCount++];
+    sizeClass.size = size;
+    sizeClass.freeSlots = nullptr;
+    return &sizeClass;
+}
+
+void* OsmAnd::RoutePlannerContext::RouteCalculationSegmentsPool::allocate( size_t size )
+{
+    size = (size + Alignment - 1) & ~static_cast<size_t>(Alignment - 1);
+
+    // Sizes that pool does not track are served by heap
+    const auto sizeClass = findSizeClass(size, true);
+    if(!sizeClass)
+        return ::operator new(size);
+
+    if(sizeClass->freeSlots)
+    {
+        const auto slot = sizeClass->freeSlots;
+        sizeClass->freeSlots = slot->next;
+        return slot;
+    }
+
+    if(_chunkBytesLeft < size)
+    {
+        _chunkCursor = static_cast<char*>(::operator new(ChunkSize));
+        _chunkBytesLeft = ChunkSize;
+        _chunks.push_back(_chunkCursor);
+    }
+    const auto ptr = _chunkCursor;
+    _chunkCursor += size;
+    _chunkBytesLeft -= size;
+    return ptr;
+}
+
+size_t OsmAnd::RoutePlannerContext::RouteCalculationSegmentsPool::getConsumedMemory() const
+{
+    return _chunks.size() * static_cast<size_t>(ChunkSize);
+}
+
+void OsmAnd::RoutePlannerContext::RouteCalculationSegmentsPool::deallocate( void* ptr, size_t size )
+{
+    size = (size + Alignment - 1) & ~static_cast<size_t>(Alignment - 1);
+
+    const auto sizeClass = findSizeClass(size, false);
+    if(!sizeClass)
+    {
+        ::operator delete(ptr);
+        return;
+    }
 
+    const auto slot = static_cast<FreeSlot*>(ptr);
+    slot->next = sizeClass->freeSlots;
+    sizeClass->freeSlots = slot;
 }
@@ -19,11 +19,12 @@ OsmAnd::RouteCalculationResult OsmAnd::RoutePlanner::prepareResult(
 {
     // Prepare result
     QVector< std::shared_ptr<RouteSegment> > route;
-    auto pFinalSegment = dynamic_cast<RoutePlannerContext::RouteCalculationFinalSegment*>(finalSegment.get());
+    const auto& opposite = finalSegment->_opposite;
+    const auto reverseWaySearch = finalSegment->_reverseWaySearch;
 
     // Get results from opposite direction roads
-    auto segment = pFinalSegment->_reverseWaySearch ? finalSegment : pFinalSegment->opposite->parent;
-    auto parentSegmentStart = pFinalSegment->_reverseWaySearch ? pFinalSegment->opposite->pointIndex : pFinalSegment->opposite->parentEndPointIndex;
+    auto segment = reverseWaySearch ? finalSegment : opposite->parent;
+    auto parentSegmentStart = reverseWaySearch ? opposite->pointIndex : opposite->parentEndPointIndex;
     int i = 0;
     while (segment)
     {
@@ -38,8 +39,8 @@ OsmAnd::RouteCalculationResult OsmAnd::RoutePlanner::prepareResult(
     // Reverse it just to attach good direction roads
     std::reverse(route.begin(), route.end());
     i = 0;
-    segment = pFinalSegment->_reverseWaySearch ? pFinalSegment->opposite->parent : finalSegment;
-    auto parentSegmentEnd = pFinalSegment->_reverseWaySearch ? pFinalSegment->opposite->parentEndPointIndex : pFinalSegment->opposite->pointIndex;
+    segment = reverseWaySearch ? opposite->parent : finalSegment;
+    auto parentSegmentEnd = reverseWaySearch ? opposite->parentEndPointIndex : opposite->pointIndex;
     while (segment)
     {
         std::shared_ptr<RouteSegment> routeSegment(new RouteSegment(segment->road, segment->pointIndex, parentSegmentEnd));
@@ -188,7 +189,7 @@ void OsmAnd::RoutePlanner::attachRouteSegments(
 
     // Try to attach all segments except with current id
     const auto& p31 = segment->road->points[pointIdx];
-    auto rt = OsmAnd::RoutePlanner::loadRouteCalculationSegment(context->owner, p31.x, p31.y);
+    auto rt = OsmAnd::RoutePlanner::loadRouteCalculationSegment(context, p31.x, p31.y);
     while(rt)
     {
         if(rt->road->id != segment->road->id && rt->road->id != previousRoadId)
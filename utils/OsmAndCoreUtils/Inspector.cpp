@@ -260,10 +260,11 @@ void printMapDetailInfo(std::ostream& output, const OsmAnd::Inspector::Configura
         {
             auto mapObject = *itMapObject;
             output << xT("\t\t") << mapObject->id << std::endl;
-            if(mapObject->names.count() > 0)
+            const auto names = mapObject->getNames();
+            if(names.count() > 0)
             {
                 output << xT("\t\t\tNames:");
-                for(auto itName = mapObject->names.begin(); itName != mapObject->names.end(); ++itName)
+                for(auto itName = names.begin(); itName != names.end(); ++itName)
                     output << QStringToStlString(itName.value()) << xT(", ");
                 output << std::endl;
             }
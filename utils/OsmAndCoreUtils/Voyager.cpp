@@ -218,7 +218,8 @@ void performJourney(std::ostream &output, const OsmAnd::Voyager::Configuration&
         if(cfg.generateXml)
             output << xT("<!--");
         output << xT("\tRoad name(s): ");
-        if(startRoad->names.size() == 0)
+        const auto startRoadNames = startRoad->getNames();
+        if(startRoadNames.size() == 0)
         {
             output << xT("\t[none] (") << startRoad->id << xT(")");
             if(cfg.generateXml)
@@ -227,7 +228,7 @@ void performJourney(std::ostream &output, const OsmAnd::Voyager::Configuration&
         }
         else
         {
-            for(auto itName = startRoad->names.begin(); itName != startRoad->names.end(); ++itName)
+            for(auto itName = startRoadNames.begin(); itName != startRoadNames.end(); ++itName)
                 output << QStringToStlString(itName.value()) << xT("; ");
             output << xT(" (") << startRoad->id << xT(")");
             if(cfg.generateXml)
@@ -245,7 +246,8 @@ void performJourney(std::ostream &output, const OsmAnd::Voyager::Configuration&
         if(cfg.generateXml)
             output << xT("<!--");
         output << xT("\tRoad name(s): ");
-        if(endRoad->names.size() == 0)
+        const auto endRoadNames = endRoad->getNames();
+        if(endRoadNames.size() == 0)
         {
             output << xT("\t[none] (") << endRoad->id << xT(")");
             if(cfg.generateXml)
@@ -254,7 +256,7 @@ void performJourney(std::ostream &output, const OsmAnd::Voyager::Configuration&
         }
         else
         {
-            for(auto itName = endRoad->names.begin(); itName != endRoad->names.end(); ++itName)
+            for(auto itName = endRoadNames.begin(); itName != endRoadNames.end(); ++itName)
                 output << QStringToStlString(itName.value()) << xT("; ");
             output << xT(" (") << endRoad->id << xT(")");
             if(cfg.generateXml)
@@ -392,8 +394,9 @@ void performJourney(std::ostream &output, const OsmAnd::Voyager::Configuration&
         output << xT("\t\tend=\"") << segment->endPointIndex << xT("\"") << std::endl;
 
         QString name;
-        if(!segment->road->names.isEmpty())
-            name += segment->road->names.begin().value();
+        const auto roadNames = segment->road->getNames();
+        if(!roadNames.isEmpty())
+            name += roadNames.begin().value();
         /*String ref = res.getObject().getRef();
         if (ref != null) {
             name += " (" + ref + ") ";